@@ -1,6 +1,10 @@
 // Nadav034@gmail.com
 
 #include "Algorithms.hpp"
+#include "DepthFirstSearch.hpp"
+#include "PriorityQueues.hpp"
+#include "ThreadPool.hpp"
+#include "BlockedProduct.hpp"
 #include <queue>
 #include <limits>
 #include <algorithm>
@@ -8,8 +12,377 @@
 #include <set>
 #include <sstream>
 #include <stack>
+#include <stdexcept>
+#include <atomic>
+#include <memory>
+#include <functional>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 using namespace std;
+
+// Bit of vertex v inside its 64-bit word
+static inline uint64_t vertexBit(int v) {
+    return uint64_t(1) << (v & 63);
+}
+
+namespace {
+
+// Targets of a search that may stop early: done() turns true once every target
+// has been reached. An empty target list never completes, so the search runs
+// over everything reachable.
+struct TargetSet {
+    std::vector<char> pending;
+    int remaining;
+
+    TargetSet(int numVer, const std::vector<int>& targets) : remaining(0) {
+        if (!targets.empty()) {
+            pending.assign(numVer, 0);
+            for (int v : targets) {
+                remaining += pending[v] == 0;
+                pending[v] = 1;
+            }
+        }
+    }
+
+    void reach(int v) {
+        if (!pending.empty() && pending[v]) {
+            pending[v] = 0;
+            --remaining;
+        }
+    }
+
+    bool done() const {
+        return !pending.empty() && remaining == 0;
+    }
+};
+
+} // namespace
+
+// Beamer's switching thresholds for the hybrid BFS: go bottom-up once the
+// frontier's edges exceed 1/alpha of the edges not yet explored, and return
+// top-down once the frontier holds fewer than 1/beta of the vertices. Small
+// graphs always run top-down.
+static const long long bfsAlpha = 14;
+static const long long bfsBeta = 24;
+static const int bfsBottomUpMinVertices = 1024;
+
+namespace {
+
+/**
+ * Level-synchronous, direction-optimizing BFS. Levels are expanded top-down
+ * from the frontier while it is small; once it holds a large share of the
+ * remaining edges, each undiscovered vertex instead looks for any parent in
+ * the frontier bitmap and stops at the first one (bottom-up).
+ *
+ * Levels with enough work are expanded on the shared thread pool, in chunks
+ * claimed dynamically. Top-down, every new vertex is claimed by the earliest
+ * frontier position that reaches it (an atomic minimum), and each chunk then
+ * lists the vertices it claimed; bottom-up, chunks cover whole words of
+ * vertices. Concatenating the chunk lists in order yields the same levels,
+ * parents and next frontier as the serial loop.
+ *
+ * One search can run from several starts: vertices reached by an earlier run
+ * are not entered again, as in a BFS forest.
+ */
+class BreadthFirstSearch {
+public:
+    std::vector<int> distance;   // level in the run that reached the vertex, or -1
+    std::vector<int> parent;     // BFS parent, or -1 at starts and unreached vertices
+
+    explicit BreadthFirstSearch(const Graph& graph)
+        : distance(graph.getVertexNum(), -1), parent(graph.getVertexNum(), -1), graph(graph),
+          numVer(graph.getVertexNum()), words(graph.isBitPacked() ? graph.getBitWords() : 0),
+          symmetric(!graph.isGraphDirected()), unexploredEdges(0), seen(words, 0) {
+        for (int v = 0; v < numVer; ++v) {
+            unexploredEdges += graph.getDegree(v);
+        }
+        ThreadPool& pool = ThreadPool::shared();
+        threads = pool.getThreadCount();
+        minParallelWork = pool.getMinParallelWork();
+    }
+
+    /**
+     * Searches from start.
+     *
+     * @param start The start vertex; must not have been reached yet.
+     * @param targets The search stops after the level that reaches the last of them; empty to search everything.
+     */
+    void run(int start, const std::vector<int>& targets) {
+        TargetSet remaining(numVer, targets);
+        distance[start] = 0;
+        markReached(start);
+        remaining.reach(start);
+        std::vector<int> frontier(1, start);
+        std::vector<int> next;
+        bool bottomUp = false;
+
+        for (int level = 1; !frontier.empty() && !remaining.done(); ++level) {
+            long long frontierEdges = 0;
+            for (int v : frontier) {
+                frontierEdges += graph.getDegree(v);
+            }
+            if (!bottomUp) {
+                bottomUp = numVer >= bfsBottomUpMinVertices && frontierEdges * bfsAlpha > unexploredEdges;
+            } else if (static_cast<long long>(frontier.size()) * bfsBeta < numVer) {
+                bottomUp = false;
+            }
+            next.clear();
+
+            if (bottomUp) {
+                expandBottomUp(frontier, level, next);
+            } else if (threads > 1 && frontierEdges >= minParallelWork) {
+                expandTopDownParallel(frontier, level, frontierEdges, next);
+            } else {
+                expandTopDown(frontier, level, next);
+            }
+
+            for (int v : next) {
+                remaining.reach(v);
+            }
+            frontier.swap(next);
+        }
+    }
+
+    /**
+     * Searches from each start with a plain top-down BFS, the starts spread
+     * over the shared thread pool. The starts must lie in different components
+     * of a symmetric graph, so no two searches meet. Suits many small
+     * components, each too small to split across threads.
+     *
+     * @param starts The start vertices; none of them reached yet.
+     */
+    void runEach(const std::vector<int>& starts) {
+        int count = static_cast<int>(starts.size());
+        if (count == 0) {
+            return;
+        }
+        std::atomic<long long> explored(0);
+        int grain = std::max(1, count / (threads * 8));
+        long long workPerStart = 1 + (unexploredEdges + numVer) / count;
+        ThreadPool::shared().parallelForDynamic(0, count, grain, workPerStart, [&](int begin, int end) {
+            std::vector<int> queue;
+            long long edges = 0;
+            for (int s = begin; s < end; ++s) {
+                queue.assign(1, starts[s]);
+                distance[starts[s]] = 0;
+                for (size_t head = 0; head < queue.size(); ++head) {
+                    int v = queue[head];
+                    int pos = graph.edgeBegin(v), u, weight;
+                    edges += graph.getDegree(v);
+                    while (graph.nextEdge(v, pos, u, weight)) {
+                        if (distance[u] == -1) {
+                            distance[u] = distance[v] + 1;
+                            parent[u] = v;
+                            queue.push_back(u);
+                        }
+                    }
+                }
+            }
+            explored += edges;
+        });
+        // The searched vertices stay out of seen: no other component's row reaches them
+        unexploredEdges -= explored;
+    }
+
+private:
+    const Graph& graph;
+    int numVer;
+    int words;                                // bit-packed row length, or 0
+    bool symmetric;
+    long long unexploredEdges;
+    int threads;
+    long long minParallelWork;
+    std::vector<uint64_t> seen;               // reached vertices, kept for bit-packed graphs
+    std::vector<uint64_t> frontierBits;
+    std::unique_ptr<std::atomic<int>[]> owner;
+    std::vector<std::vector<int>> chunkNext;
+
+    void markReached(int v) {
+        unexploredEdges -= graph.getDegree(v);
+        if (words > 0) {
+            seen[v >> 6] |= vertexBit(v);
+        }
+    }
+
+    // Moves the chunk lists of a parallel step into next, in chunk order.
+    void collectChunks(int chunks, std::vector<int>& next) {
+        for (int c = 0; c < chunks; ++c) {
+            for (int v : chunkNext[c]) {
+                if (owner) {
+                    owner[v].store(std::numeric_limits<int>::max(), std::memory_order_relaxed);
+                }
+                markReached(v);
+                next.push_back(v);
+            }
+            chunkNext[c].clear();
+        }
+    }
+
+    void expandTopDown(const std::vector<int>& frontier, int level, std::vector<int>& next) {
+        for (int v : frontier) {
+            if (words > 0) {
+                // Whole words of undiscovered neighbours at once
+                const uint64_t* row = graph.getBitRow(v);
+                for (int w = 0; w < words; ++w) {
+                    uint64_t fresh = row[w] & ~seen[w];
+                    while (fresh != 0) {
+                        int i = (w << 6) + __builtin_ctzll(fresh);
+                        fresh &= fresh - 1;
+                        distance[i] = level;
+                        parent[i] = v;
+                        markReached(i);
+                        next.push_back(i);
+                    }
+                }
+                continue;
+            }
+
+            int pos = graph.edgeBegin(v), i, weight;
+            while (graph.nextEdge(v, pos, i, weight)) {
+                if (distance[i] == -1) {
+                    distance[i] = level;
+                    parent[i] = v;
+                    markReached(i);
+                    next.push_back(i);
+                }
+            }
+        }
+    }
+
+    void expandTopDownParallel(const std::vector<int>& frontier, int level, long long frontierEdges, std::vector<int>& next) {
+        if (!owner) {
+            owner.reset(new std::atomic<int>[numVer]);
+            for (int v = 0; v < numVer; ++v) {
+                owner[v].store(std::numeric_limits<int>::max(), std::memory_order_relaxed);
+            }
+        }
+        int size = static_cast<int>(frontier.size());
+        int grain = std::max(64, size / (threads * 8));
+        int chunks = (size + grain - 1) / grain;
+        if (static_cast<int>(chunkNext.size()) < chunks) {
+            chunkNext.resize(chunks);
+        }
+        long long workPerVertex = frontierEdges / size + 1;
+        ThreadPool& pool = ThreadPool::shared();
+
+        // Claim every undiscovered neighbour for the earliest frontier position reaching it
+        pool.parallelForDynamic(0, size, grain, workPerVertex, [&](int begin, int end) {
+            for (int f = begin; f < end; ++f) {
+                forEachCandidate(frontier[f], true, [&](int u) {
+                    int current = owner[u].load(std::memory_order_relaxed);
+                    while (f < current && !owner[u].compare_exchange_weak(current, f, std::memory_order_relaxed)) {
+                    }
+                });
+            }
+        });
+        // Each position lists the neighbours it won, in neighbour order
+        pool.parallelForDynamic(0, size, grain, workPerVertex, [&](int begin, int end) {
+            std::vector<int>& claimed = chunkNext[begin / grain];
+            for (int f = begin; f < end; ++f) {
+                int v = frontier[f];
+                forEachCandidate(v, false, [&](int u) {
+                    if (owner[u].load(std::memory_order_relaxed) == f) {
+                        distance[u] = level;
+                        parent[u] = v;
+                        claimed.push_back(u);
+                    }
+                });
+            }
+        });
+        collectChunks(chunks, next);
+    }
+
+    // Calls visit(u) for the neighbours of v that may still be undiscovered.
+    // Only the first pass may read distance, which the second pass writes.
+    template <typename Visit>
+    void forEachCandidate(int v, bool checkDistance, Visit visit) const {
+        if (words > 0) {
+            const uint64_t* row = graph.getBitRow(v);
+            for (int w = 0; w < words; ++w) {
+                uint64_t fresh = row[w] & ~seen[w];
+                while (fresh != 0) {
+                    visit((w << 6) + __builtin_ctzll(fresh));
+                    fresh &= fresh - 1;
+                }
+            }
+            return;
+        }
+        int pos = graph.edgeBegin(v), u, weight;
+        while (graph.nextEdge(v, pos, u, weight)) {
+            if (!checkDistance || distance[u] == -1) {
+                visit(u);
+            }
+        }
+    }
+
+    void expandBottomUp(const std::vector<int>& frontier, int level, std::vector<int>& next) {
+        // The graph builds its incoming edges on first use; do that here rather
+        // than inside the parallel loop
+        graph.inEdgeBegin(0);
+        frontierBits.assign((numVer + 63) / 64, 0);
+        for (int v : frontier) {
+            frontierBits[v >> 6] |= vertexBit(v);
+        }
+        if (threads > 1 && numVer >= minParallelWork) {
+            // Chunks of whole words, so chunk order is vertex order
+            int grain = std::max(1024, (numVer / (threads * 8) + 63) & ~63);
+            int chunks = (numVer + grain - 1) / grain;
+            if (static_cast<int>(chunkNext.size()) < chunks) {
+                chunkNext.resize(chunks);
+            }
+            ThreadPool::shared().parallelForDynamic(0, numVer, grain, 1, [&](int begin, int end) {
+                std::vector<int>& found = chunkNext[begin / grain];
+                for (int v = begin; v < end; ++v) {
+                    if (distance[v] == -1 && adoptParent(v, level)) {
+                        found.push_back(v);
+                    }
+                }
+            });
+            collectChunks(chunks, next);
+            return;
+        }
+        for (int v = 0; v < numVer; ++v) {
+            if (distance[v] == -1 && adoptParent(v, level)) {
+                markReached(v);
+                next.push_back(v);
+            }
+        }
+    }
+
+    // Looks for a frontier vertex among the in-neighbours of v and, if there is
+    // one, makes the first one found the parent of v.
+    bool adoptParent(int v, int level) {
+        int found = -1;
+        if (symmetric && words > 0) {
+            const uint64_t* row = graph.getBitRow(v);
+            for (int w = 0; w < words && found == -1; ++w) {
+                uint64_t hit = row[w] & frontierBits[w];
+                if (hit != 0) {
+                    found = (w << 6) + __builtin_ctzll(hit);
+                }
+            }
+        } else {
+            int pos = graph.inEdgeBegin(v), u, weight;
+            while (graph.nextInEdge(v, pos, u, weight)) {
+                if (frontierBits[u >> 6] & vertexBit(u)) {
+                    found = u;
+                    break;
+                }
+            }
+        }
+        if (found == -1) {
+            return false;
+        }
+        distance[v] = level;
+        parent[v] = found;
+        return true;
+    }
+};
+
+} // namespace
+
 // Depth-First Search utility for connectivity check
 /**
  * Performs DFS to mark visited vertices for connectivity check.
@@ -20,267 +393,1475 @@ using namespace std;
  */
 void Algorithms::DFSUtil(const Graph& graph, int v, std::vector<bool>& visited) {
     visited[v] = true;
-    const auto& matrix = graph.getGraph();
-    for (int i = 0; i < graph.getVertexNum(); ++i) {
-        if (matrix[v][i] != 0 && !visited[i]) {
-            DFSUtil(graph, i, visited);
+    if (graph.isBitPacked()) {
+        // Grow the reached set a word at a time: a row's unvisited neighbours
+        // are row & ~seen, 64 candidates per AND.
+        int words = graph.getBitWords();
+        std::vector<uint64_t> seen(words, 0);
+        for (size_t i = 0; i < visited.size(); ++i) {
+            if (visited[i]) {
+                seen[i >> 6] |= vertexBit(static_cast<int>(i));
+            }
+        }
+        std::vector<int> pending(1, v);
+        while (!pending.empty()) {
+            int u = pending.back();
+            pending.pop_back();
+            const uint64_t* row = graph.getBitRow(u);
+            for (int w = 0; w < words; ++w) {
+                uint64_t fresh = row[w] & ~seen[w];
+                seen[w] |= fresh;
+                while (fresh != 0) {
+                    int i = (w << 6) + __builtin_ctzll(fresh);
+                    fresh &= fresh - 1;
+                    visited[i] = true;
+                    pending.push_back(i);
+                }
+            }
+        }
+        return;
+    }
+    DepthFirstSearch search(graph);
+    for (size_t i = 0; i < visited.size(); ++i) {
+        if (visited[i] && static_cast<int>(i) != v) {
+            search.markVisited(static_cast<int>(i));
+        }
+    }
+    DFSVisitor visitor;
+    search.run(v, visitor);
+    for (size_t i = 0; i < visited.size(); ++i) {
+        if (search.isVisited(static_cast<int>(i))) {
+            visited[i] = true;
         }
     }
 }
 
 // Function to check if the graph is connected
 /**
- * Checks if the graph is connected.
+ * Checks if the graph is connected, using the graph's connectivity index (see
+ * Graph::getComponentCount), so repeated checks while a graph grows through
+ * operator+= cost near-constant time. A directed graph must also be strongly
+ * connected, which is read off one Tarjan pass instead of a second DFS over a
+ * transposed copy.
  *
  * @param graph The graph to check.
  * @return 1 if connected, 0 otherwise.
  */
-int Algorithms::isConnected( Graph& graph) {
+int Algorithms::isConnected(const Graph& graph) {
     if(graph.getIsEmpty()){
-        cout<<"graph is empty"<<endl;
         return 0;
     }
+    if (graph.getComponentCount() != 1) {
+        return 0;
+    }
+    if (graph.isGraphDirected()) {
+        return stronglyConnectedComponents(graph).count == 1 ? 1 : 0;
+    }
+    return 1;
+}
+
+// Tarjan's algorithm as DepthFirstSearch hooks. A vertex stays on the Tarjan
+// stack until its component closes, which is when it has been visited but has
+// no component yet, so no separate on-stack flags are needed.
+namespace {
+struct TarjanVisitor : DFSVisitor {
+    const DepthFirstSearch& search;
+    std::vector<int>& component;
+    std::vector<int> index;
+    std::vector<int> low;
+    std::vector<int> pending;
+    int counter;
+    int count;
+
+    TarjanVisitor(const DepthFirstSearch& search, std::vector<int>& component, int numVer)
+        : search(search), component(component), index(numVer), low(numVer), counter(0), count(0) {
+        pending.reserve(numVer);
+    }
+
+    bool discover(int v) {
+        index[v] = low[v] = counter++;
+        pending.push_back(v);
+        return false;
+    }
+
+    bool backEdge(int u, int v, int) {
+        low[u] = std::min(low[u], index[v]);
+        return false;
+    }
+
+    bool otherEdge(int u, int v, int) {
+        if (component[v] == -1) {
+            low[u] = std::min(low[u], index[v]);
+        }
+        return false;
+    }
+
+    bool finish(int v) {
+        if (low[v] == index[v]) {
+            int w;
+            do {
+                w = pending.back();
+                pending.pop_back();
+                component[w] = count;
+            } while (w != v);
+            ++count;
+        }
+        int parent = search.getParents()[v];
+        if (parent != -1) {
+            low[parent] = std::min(low[parent], low[v]);
+        }
+        return false;
+    }
+};
+}
+
+/**
+ * Computes the strongly connected components with an iterative Tarjan search
+ * in O(V + E) time on sparse graphs, plus the condensation DAG.
+ *
+ * @param graph The graph.
+ * @return The component of every vertex, the component sizes and count, and the condensation.
+ */
+Algorithms::StrongComponents Algorithms::stronglyConnectedComponents(const Graph& graph) {
+    int numVer = graph.getVertexNum();
+    StrongComponents result;
+    result.component.assign(numVer, -1);
+    {
+        DepthFirstSearch search(graph);
+        TarjanVisitor tarjan(search, result.component, numVer);
+        search.runAll(tarjan);
+        result.count = tarjan.count;
+    }
+
+    // Tarjan closes sink components first; flip the ids into topological order
+    result.sizes.assign(result.count, 0);
+    for (int v = 0; v < numVer; ++v) {
+        result.component[v] = result.count - 1 - result.component[v];
+        ++result.sizes[result.component[v]];
+    }
+
+    // Bucket the edges that cross components by source component, then dedupe each row
+    std::vector<int> offsets(result.count + 1, 0);
+    for (int u = 0; u < numVer; ++u) {
+        int pos = graph.edgeBegin(u), v, weight;
+        while (graph.nextEdge(u, pos, v, weight)) {
+            if (result.component[u] != result.component[v]) {
+                ++offsets[result.component[u] + 1];
+            }
+        }
+    }
+    for (int c = 0; c < result.count; ++c) {
+        offsets[c + 1] += offsets[c];
+    }
+    std::vector<int> fill(offsets.begin(), offsets.end() - 1);
+    std::vector<int> crossing(offsets[result.count]);
+    for (int u = 0; u < numVer; ++u) {
+        int pos = graph.edgeBegin(u), v, weight;
+        while (graph.nextEdge(u, pos, v, weight)) {
+            if (result.component[u] != result.component[v]) {
+                crossing[fill[result.component[u]]++] = result.component[v];
+            }
+        }
+    }
+    std::vector<int> dagOffsets(1, 0), dagTargets;
+    for (int c = 0; c < result.count; ++c) {
+        std::sort(crossing.begin() + offsets[c], crossing.begin() + offsets[c + 1]);
+        for (int i = offsets[c]; i < offsets[c + 1]; ++i) {
+            if (i == offsets[c] || crossing[i] != crossing[i - 1]) {
+                dagTargets.push_back(crossing[i]);
+            }
+        }
+        dagOffsets.push_back(static_cast<int>(dagTargets.size()));
+    }
+    std::vector<int> dagWeights(dagTargets.size(), 1);
+    result.condensation.loadSparseGraph(result.count, dagOffsets, dagTargets, dagWeights);
+    return result;
+}
+
+// Neighbours each vertex links to before connectedComponents samples the largest component.
+static const int componentSampleRounds = 2;
+static const int componentPrefetchDistance = 16;
+
+// Union-find link for connectedComponents. parent[v] <= v always holds, so
+// each tree is rooted at its smallest vertex and links cannot close a loop.
+// A root is hooked under the other with a compare-and-swap; if another thread
+// moved it first, the link retries from the new parents.
+static void linkVertices(std::atomic<int>* parent, int u, int v) {
+    int p1 = parent[u].load(std::memory_order_relaxed);
+    int p2 = parent[v].load(std::memory_order_relaxed);
+    while (p1 != p2) {
+        int high = std::max(p1, p2), low = std::min(p1, p2);
+        int parentHigh = parent[high].load(std::memory_order_relaxed);
+        if (parentHigh == low) {
+            return;
+        }
+        if (parentHigh == high && parent[high].compare_exchange_strong(parentHigh, low, std::memory_order_relaxed)) {
+            return;
+        }
+        p1 = parent[parent[high].load(std::memory_order_relaxed)].load(std::memory_order_relaxed);
+        p2 = parent[low].load(std::memory_order_relaxed);
+    }
+}
+
+// Points v straight at its root. Parents only ever move towards the root, so
+// this is safe while other threads link.
+static void compressVertex(std::atomic<int>* parent, int v) {
+    int p = parent[v].load(std::memory_order_relaxed);
+    int grandparent = parent[p].load(std::memory_order_relaxed);
+    while (p != grandparent) {
+        parent[v].store(grandparent, std::memory_order_relaxed);
+        p = grandparent;
+        grandparent = parent[p].load(std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Computes the connected components with a concurrent union-find (Afforest).
+ * Every vertex first links to its first two neighbours only, which on most
+ * graphs already joins almost all of the largest component. That component is
+ * found by sampling 1024 vertices. The remaining edges are then linked from
+ * every vertex outside it; an edge into it is still linked from the other
+ * end, so the largest component's own edges are never read. Directed graphs
+ * give their weakly connected components; an edge is only seen from its
+ * source there, so no vertex is skipped. Each phase is spread over the thread
+ * pool, and the result does not depend on the thread count.
+ *
+ * @param graph The graph.
+ * @return The component of every vertex, numbered by smallest vertex, and the component sizes and count.
+ */
+Algorithms::ConnectedComponents Algorithms::connectedComponents(const Graph& graph) {
     int numVer = graph.getVertexNum();
-    std::vector<bool> visited(numVer, false);
-    // Perform DFS starting from the first vertex
-    DFSUtil(graph, 0, visited);
-    // Check if all vertices are visited
-    for (int i = 0; i < numVer; ++i) {
-        if (!visited[i]) {
-            return 0; // Not connected
+    ThreadPool& pool = ThreadPool::shared();
+    long long degree = 1 + graph.getNumberOfEdges() / std::max(numVer, 1);
+    std::unique_ptr<std::atomic<int>[]> parent(new std::atomic<int>[numVer]);
+    std::vector<int> cursor(numVer);
+    pool.parallelFor(0, numVer, 1, [&](int begin, int end) {
+        for (int v = begin; v < end; ++v) {
+            parent[v].store(v, std::memory_order_relaxed);
+            cursor[v] = graph.edgeBegin(v);
         }
+    });
+    auto compressAll = [&]() {
+        pool.parallelFor(0, numVer, 1, [&](int begin, int end) {
+            for (int v = begin; v < end; ++v) {
+                compressVertex(parent.get(), v);
+            }
+        });
+    };
+
+    // Each round links every vertex to its next neighbour; the cursors then
+    // resume after the sampled edges
+    bool prefetch = graph.isSparse();
+    for (int round = 0; round < componentSampleRounds; ++round) {
+        pool.parallelFor(0, numVer, 1, [&](int begin, int end) {
+            for (int v = begin; v < end; ++v) {
+                int u, weight;
+                if (prefetch && v + componentPrefetchDistance < end) {
+                    int ahead = v + componentPrefetchDistance, pos = cursor[ahead];
+                    if (graph.nextEdge(ahead, pos, u, weight)) {
+                        __builtin_prefetch(&parent[u]);
+                    }
+                }
+                if (graph.nextEdge(v, cursor[v], u, weight)) {
+                    linkVertices(parent.get(), v, u);
+                }
+            }
+        });
+        compressAll();
     }
-    // For directed graphs, check reverse reachability
-    if (graph.isGraphDirected()) {
-        // Create a transpose of the graph
-        std::vector<std::vector<int>> transpose(numVer, std::vector<int>(numVer, 0));
-        const auto& matrix = graph.getGraph();
-        for (int i = 0; i < numVer; ++i) {
-            for (int j = 0; j < numVer; ++j) {
-                transpose[j][i] = matrix[i][j];
+
+    // The most frequent root among the sampled vertices
+    int largest = -1;
+    if (!graph.isGraphDirected() && numVer > 0) {
+        std::vector<int> sample(1024);
+        uint64_t seed = 0x9E3779B97F4A7C15ULL;
+        for (int& root : sample) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            root = parent[(seed >> 33) % numVer].load(std::memory_order_relaxed);
+        }
+        std::sort(sample.begin(), sample.end());
+        int bestRun = 0;
+        for (size_t i = 0, j = 0; i < sample.size(); i = j) {
+            while (j < sample.size() && sample[j] == sample[i]) {
+                ++j;
+            }
+            if (static_cast<int>(j - i) > bestRun) {
+                bestRun = static_cast<int>(j - i);
+                largest = sample[i];
+            }
+        }
+    }
+
+    pool.parallelFor(0, numVer, degree, [&](int begin, int end) {
+        for (int v = begin; v < end; ++v) {
+            if (parent[v].load(std::memory_order_relaxed) == largest) {
+                continue;
+            }
+            int u, weight;
+            while (graph.nextEdge(v, cursor[v], u, weight)) {
+                linkVertices(parent.get(), v, u);
+            }
+        }
+    });
+    compressAll();
+
+    // Every vertex now points at its root, the smallest vertex of its component
+    ConnectedComponents result;
+    result.component.resize(numVer);
+    result.count = 0;
+    for (int v = 0; v < numVer; ++v) {
+        int root = parent[v].load(std::memory_order_relaxed);
+        if (root == v) {
+            result.component[v] = result.count++;
+            result.sizes.push_back(0);
+        } else {
+            result.component[v] = result.component[root];
+        }
+        ++result.sizes[result.component[v]];
+    }
+    return result;
+}
+
+/**
+ * Queue-based Bellman-Ford (SPFA) with Tarjan's subtree disassembly. Every
+ * vertex with a finite distance starts as a root of the shortest-path tree;
+ * only vertices whose distance dropped are queued and scanned, so the search
+ * ends as soon as no distance changes. The tree is kept as a preorder thread
+ * with depths. When v improves, its old subtree is unlinked and its vertices
+ * are skipped until they improve again, because their distances are stale.
+ * If the improving vertex u is itself in that subtree, the parent edges
+ * u -> ... -> v -> u close a negative cycle, and the search stops.
+ *
+ * @param g The graph.
+ * @param dist Starting distances, updated in place; INF marks unreached vertices.
+ * @param parent Parent vector, updated in place.
+ * @return A vertex on a negative cycle, reached from it through parent, or -1 if there is none.
+ */
+static int relaxFromSources(const Graph& g, std::vector<int>& dist, std::vector<int>& parent) {
+    int V = g.getVertexNum();
+    const int INF = std::numeric_limits<int>::max();
+
+    // Preorder thread of the tree; index V is a sentinel above all the roots
+    std::vector<int> next(V + 1, V), prev(V + 1, V), depth(V, -1);
+    std::vector<int> queue(V);
+    std::vector<char> queued(V, 0);
+    int head = 0, count = 0;
+    for (int v = 0; v < V; ++v) {
+        if (dist[v] != INF) {
+            depth[v] = 0;
+            next[prev[V]] = v;
+            prev[v] = prev[V];
+            next[v] = V;
+            prev[V] = v;
+            queue[count++] = v;
+            queued[v] = 1;
+        }
+    }
+
+    while (count > 0) {
+        int u = queue[head];
+        head = head + 1 == V ? 0 : head + 1;
+        --count;
+        queued[u] = 0;
+        if (depth[u] == -1) {
+            continue;   // disassembled since it was queued
+        }
+
+        int pos = g.edgeBegin(u), v, weight;
+        while (g.nextEdge(u, pos, v, weight)) {
+            if (dist[u] + weight >= dist[v]) {
+                continue;
+            }
+            if (v == u) {
+                parent[u] = u;
+                return u;
+            }
+            if (depth[v] != -1) {
+                int x = next[v];
+                while (x != V && depth[x] > depth[v]) {
+                    if (x == u) {
+                        parent[v] = u;
+                        return v;
+                    }
+                    depth[x] = -1;
+                    x = next[x];
+                }
+                next[prev[v]] = x;
+                prev[x] = prev[v];
             }
+            dist[v] = dist[u] + weight;
+            parent[v] = u;
+            depth[v] = depth[u] + 1;
+            next[v] = next[u];
+            prev[next[u]] = v;
+            next[u] = v;
+            prev[v] = u;
+            if (!queued[v]) {
+                int tail = head + count;
+                queue[tail >= V ? tail - V : tail] = v;
+                ++count;
+                queued[v] = 1;
+            }
+        }
+    }
+    return -1;
+}
+
+// Function to relax edges in the graph
+/**
+ * Relaxes the edges of the graph to update distances and parents, until no
+ * distance changes or a negative cycle is found (see relaxFromSources).
+ *
+ * @param g The graph.
+ * @param dist Distance vector.
+ * @param parent Parent vector.
+ * @return True if a negative cycle is reachable from the vertices with finite distances.
+ */
+bool Algorithms::relaxEdges(const Graph &g, std::vector<int> &dist, std::vector<int> &parent) {
+    return relaxFromSources(g, dist, parent) != -1;
+}
+
+
+
+// Writes the parent chain ending at end into path, in order from its root.
+static void tracePath(const std::vector<int>& parent, int end, std::vector<int>& path) {
+    path.clear();
+    for (int v = end; v != -1; v = parent[v]) {
+        path.push_back(v);
+    }
+    std::reverse(path.begin(), path.end());
+}
+
+// Function to find the shortest path in an unweighted graph using BFS
+/**
+ * Finds the shortest path in an unweighted graph using a direction-optimizing,
+ * parallel BFS (see BreadthFirstSearch) that ends as soon as the end vertex is reached.
+ *
+ * @param graph The graph.
+ * @param start The start vertex.
+ * @param end The end vertex.
+ * @return A pair containing the shortest path length and the path itself.
+ */
+std::pair<int, std::vector<int>> Algorithms::bfsShortestPath(const Graph& graph, int start, int end) {
+    BreadthFirstSearch search(graph);
+    search.run(start, std::vector<int>(1, end));
+    const std::vector<int>& distance = search.distance;
+    const std::vector<int>& parent = search.parent;
+
+    if (distance[end] == -1) {
+        return {-1, {}}; // No path found
+    }
+
+    std::vector<int> path;
+    tracePath(parent, end, path);
+    return {distance[end], path}; // Shortest path length and path
+}
+
+// Dijkstra's search from start with the given priority queue. With non-negative
+// weights a vertex is final once popped, so the search stops when the last
+// target is popped; otherwise improved vertices are queued again until no
+// distance changes. An empty target list searches everything reachable.
+template <typename Queue>
+static void dijkstraSearch(const Graph& graph, int start, const std::vector<int>& targets, Queue& queue,
+                           std::vector<int>& distance, std::vector<int>& parent) {
+    bool stopEarly = !graph.isGraphNegWeighted();
+    TargetSet remaining(graph.getVertexNum(), stopEarly ? targets : std::vector<int>());
+    distance[start] = 0;
+    queue.update(start, 0);
+
+    while (!queue.empty()) {
+        int v = queue.pop();
+        remaining.reach(v);
+        if (remaining.done()) {
+            return;
         }
-        // Create a new Graph object for the transposed graph
-        Graph transposedGraph(transpose, graph.isGraphDirected(), graph.isGraphWeighted(), numVer);
-        // Reset visited and perform DFS on the transpose
-        std::fill(visited.begin(), visited.end(), false);
-        DFSUtil(transposedGraph, 0, visited);
-        for (int i = 0; i < numVer; ++i) {
-            if (!visited[i]) {
-                return 0; // Not strongly connected
+
+        int pos = graph.edgeBegin(v), i, weight;
+        while (graph.nextEdge(v, pos, i, weight)) {
+            if (distance[v] + weight < distance[i]) {
+                distance[i] = distance[v] + weight;
+                parent[i] = v;
+                queue.update(i, distance[i]);
             }
         }
     }
-    return 1; // Connected
 }
 
-// Function to relax edges in the graph
+// Function to find the shortest path in a weighted graph using Dijkstra's algorithm
+/**
+ * Finds the shortest path in a weighted graph using Dijkstra's algorithm.
+ * Only the real out-neighbours of each vertex are visited. A queued vertex has
+ * its key lowered in place when a shorter path is found. With non-negative
+ * weights each vertex is popped at most once; with negative weights a vertex
+ * whose distance improves after it was popped is queued again, so the search
+ * becomes label-correcting and may pop a vertex several times.
+ *
+ * @param graph The graph.
+ * @param start The start vertex.
+ * @param end The end vertex.
+ * @param queue DijkstraQueue::DAryHeap (a 4-ary heap) or DijkstraQueue::RadixHeap.
+ * @return A pair containing the shortest path length and the path itself.
+ * @throws std::invalid_argument If the radix heap is requested for a graph with negative weights.
+ */
+std::pair<int, std::vector<int>> Algorithms::dijkstraShortestPath(const Graph& graph, int start, int end, DijkstraQueue queue) {
+    int numVer = graph.getVertexNum();
+    std::vector<int> distance(numVer, std::numeric_limits<int>::max());
+    std::vector<int> parent(numVer, -1);
+
+    if (queue == DijkstraQueue::RadixHeap) {
+        if (graph.isGraphNegWeighted()) {
+            throw std::invalid_argument("The radix heap requires non-negative edge weights.");
+        }
+        RadixHeap heap(numVer);
+        dijkstraSearch(graph, start, std::vector<int>(1, end), heap, distance, parent);
+    } else {
+        IndexedDaryHeap<4> heap(numVer);
+        dijkstraSearch(graph, start, std::vector<int>(1, end), heap, distance, parent);
+    }
+
+    if (distance[end] == std::numeric_limits<int>::max()) {
+        return {-1, {}}; // No path found
+    }
+
+    std::vector<int> path;
+    tracePath(parent, end, path);
+    return {distance[end], path}; // Shortest path length and path
+}
+
+// Graphs with at least this many edges are searched with delta-stepping by
+// shortestPath when the thread pool has more than one thread.
+static const long long deltaSteppingMinEdges = 1 << 20;
+
+/**
+ * Delta-stepping single-source shortest paths for non-negative weights.
+ * Tentative distances are sorted into buckets of width delta, kept in a ring
+ * that is just long enough for the heaviest edge. The lowest non-empty bucket
+ * is emptied repeatedly: its vertices relax their light edges (weight <=
+ * delta), which may refill it. Once it stays empty, every vertex it held is
+ * final and relaxes its heavy edges once. Each relaxation round is spread over
+ * the shared thread pool, lowering distances with an atomic minimum.
+ *
+ * Parents are chosen afterwards as the smallest predecessor on a shortest path,
+ * so the tree does not depend on the thread count.
+ *
+ * @param graph The graph, with non-negative weights.
+ * @param start The start vertex.
+ * @param targets The search stops after the bucket that settles the last of them; empty to search everything.
+ * @param delta The bucket width; 0 or less picks the heaviest weight divided by the average degree.
+ * @param distance Receives the distances, std::numeric_limits<int>::max() where unreached.
+ * @param parent Receives the parent of each reached vertex, -1 elsewhere.
+ */
+static void deltaSteppingSearch(const Graph& graph, int start, const std::vector<int>& targets, int delta,
+                                std::vector<int>& distance, std::vector<int>& parent) {
+    int numVer = graph.getVertexNum();
+    const int INF = std::numeric_limits<int>::max();
+    int maxWeight = 1;
+    long long edges = 0;
+    for (int u = 0; u < numVer; ++u) {
+        int pos = graph.edgeBegin(u), v, weight;
+        while (graph.nextEdge(u, pos, v, weight)) {
+            maxWeight = std::max(maxWeight, weight);
+            ++edges;
+        }
+    }
+    if (delta <= 0) {
+        delta = static_cast<int>(std::max(1LL, static_cast<long long>(maxWeight) * numVer / std::max(edges, 1LL)));
+    }
+    long long averageDegree = edges / std::max(numVer, 1) + 1;
+
+    // A relaxation from bucket i lands at most maxWeight / delta + 1 buckets later
+    int ringSize = maxWeight / delta + 2;
+    std::vector<std::vector<int>> buckets(ringSize);
+    std::unique_ptr<std::atomic<int>[]> dist(new std::atomic<int>[numVer]);
+    for (int v = 0; v < numVer; ++v) {
+        dist[v].store(INF, std::memory_order_relaxed);
+    }
+    std::vector<int> expandedIn(numVer, -1), settledIn(numVer, -1);
+    std::vector<int> requests, frontier, settled;
+    std::vector<std::vector<int>> chunkLowered;
+    TargetSet remaining(numVer, targets);
+    ThreadPool& pool = ThreadPool::shared();
+    int threads = pool.getThreadCount();
+
+    // Relaxes the light or the heavy edges of the given vertices, then files
+    // every lowered vertex under its new bucket.
+    auto relax = [&](const std::vector<int>& from, bool light) {
+        int size = static_cast<int>(from.size());
+        if (size == 0) {
+            return;
+        }
+        int grain = std::max(64, size / (threads * 8));
+        int chunks = (size + grain - 1) / grain;
+        if (static_cast<int>(chunkLowered.size()) < chunks) {
+            chunkLowered.resize(chunks);
+        }
+        pool.parallelForDynamic(0, size, grain, averageDegree, [&](int begin, int end) {
+            std::vector<int>& lowered = chunkLowered[begin / grain];
+            for (int k = begin; k < end; ++k) {
+                int u = from[k];
+                int base = dist[u].load(std::memory_order_relaxed);
+                int pos = graph.edgeBegin(u), v, weight;
+                while (graph.nextEdge(u, pos, v, weight)) {
+                    if ((weight <= delta) != light) {
+                        continue;
+                    }
+                    int candidate = base + weight;
+                    int current = dist[v].load(std::memory_order_relaxed);
+                    while (candidate < current) {
+                        if (dist[v].compare_exchange_weak(current, candidate, std::memory_order_relaxed)) {
+                            lowered.push_back(v);
+                            break;
+                        }
+                    }
+                }
+            }
+        });
+        for (int c = 0; c < chunks; ++c) {
+            for (int v : chunkLowered[c]) {
+                buckets[(dist[v].load(std::memory_order_relaxed) / delta) % ringSize].push_back(v);
+            }
+            chunkLowered[c].clear();
+        }
+    };
+
+    dist[start].store(0, std::memory_order_relaxed);
+    buckets[0].push_back(start);
+    int phase = 0;
+    for (int i = 0, emptyRun = 0; emptyRun < ringSize; ++i) {
+        std::vector<int>& bucket = buckets[i % ringSize];
+        if (bucket.empty()) {
+            ++emptyRun;
+            continue;
+        }
+        emptyRun = 0;
+        settled.clear();
+        while (!bucket.empty()) {
+            // Drop entries that moved to a lower distance since, and duplicates
+            requests.clear();
+            requests.swap(bucket);
+            frontier.clear();
+            for (int v : requests) {
+                if (dist[v].load(std::memory_order_relaxed) / delta == i && expandedIn[v] != phase) {
+                    expandedIn[v] = phase;
+                    frontier.push_back(v);
+                    if (settledIn[v] != i) {
+                        settledIn[v] = i;
+                        settled.push_back(v);
+                    }
+                }
+            }
+            ++phase;
+            relax(frontier, true);
+        }
+        relax(settled, false);
+        for (int v : settled) {
+            remaining.reach(v);
+        }
+        if (remaining.done()) {
+            break;
+        }
+    }
+
+    distance.resize(numVer);
+    for (int v = 0; v < numVer; ++v) {
+        distance[v] = dist[v].load(std::memory_order_relaxed);
+    }
+    std::unique_ptr<std::atomic<int>[]> smallest(new std::atomic<int>[numVer]);
+    for (int v = 0; v < numVer; ++v) {
+        smallest[v].store(INF, std::memory_order_relaxed);
+    }
+    pool.parallelFor(0, numVer, averageDegree, [&](int begin, int end) {
+        for (int u = begin; u < end; ++u) {
+            if (distance[u] == INF) {
+                continue;
+            }
+            int pos = graph.edgeBegin(u), v, weight;
+            while (graph.nextEdge(u, pos, v, weight)) {
+                if (v != start && distance[u] + weight == distance[v]) {
+                    int current = smallest[v].load(std::memory_order_relaxed);
+                    while (u < current && !smallest[v].compare_exchange_weak(current, u, std::memory_order_relaxed)) {
+                    }
+                }
+            }
+        }
+    });
+    parent.assign(numVer, -1);
+    for (int v = 0; v < numVer; ++v) {
+        int u = smallest[v].load(std::memory_order_relaxed);
+        parent[v] = u == INF ? -1 : u;
+    }
+}
+
+// Function to find the shortest path using parallel delta-stepping
+/**
+ * Finds the shortest path in a graph with non-negative weights using
+ * delta-stepping (see deltaSteppingSearch), spread over the thread pool.
+ *
+ * @param graph The graph.
+ * @param start The start vertex.
+ * @param end The end vertex.
+ * @param delta The bucket width; 0 picks one from the weights and the average degree.
+ * @return A pair containing the shortest path length and the path itself.
+ * @throws std::invalid_argument If the graph has negative weights.
+ */
+std::pair<int, std::vector<int>> Algorithms::deltaSteppingShortestPath(const Graph& graph, int start, int end, int delta) {
+    if (graph.isGraphNegWeighted()) {
+        throw std::invalid_argument("Delta-stepping requires non-negative edge weights.");
+    }
+    std::vector<int> distance, parent;
+    deltaSteppingSearch(graph, start, std::vector<int>(1, end), delta, distance, parent);
+
+    if (distance[end] == std::numeric_limits<int>::max()) {
+        return {-1, {}}; // No path found
+    }
+
+    std::vector<int> path;
+    tracePath(parent, end, path);
+    return {distance[end], path}; // Shortest path length and path
+}
+
+// Reconstructs start ... end from a forward parent chain ending at meetFrom and
+// a backward one (parent = next vertex towards end) starting at meetTo.
+static std::vector<int> joinPaths(const std::vector<int>& parentForward, int meetFrom,
+                                  const std::vector<int>& parentBackward, int meetTo) {
+    std::vector<int> path;
+    for (int v = meetFrom; v != -1; v = parentForward[v]) {
+        path.push_back(v);
+    }
+    std::reverse(path.begin(), path.end());
+    for (int v = meetTo; v != -1; v = parentBackward[v]) {
+        if (v != meetFrom) {
+            path.push_back(v);
+        }
+    }
+    return path;
+}
+
+// Function to find the shortest path by searching from both ends
+/**
+ * Finds the shortest path by growing one search from start over out-edges and
+ * one from end over in-edges (see Graph::inEdgeBegin) until they meet. Each
+ * search only has to cover about half the distance, so far fewer vertices are
+ * settled than by a one-sided search. Unweighted graphs grow whole BFS levels,
+ * always on the smaller frontier, and stop after the level that first joins
+ * the two. Weighted graphs run two Dijkstra searches, alternating on the
+ * smaller queue key, and stop once the two keys add up to the best
+ * start-to-end length seen.
+ *
+ * @param graph The graph.
+ * @param start The start vertex.
+ * @param end The end vertex.
+ * @return A pair containing the shortest path length and the path itself.
+ * @throws std::invalid_argument If the graph has negative weights.
+ */
+std::pair<int, std::vector<int>> Algorithms::bidirectionalShortestPath(const Graph& graph, int start, int end) {
+    if (graph.isGraphNegWeighted()) {
+        throw std::invalid_argument("Bidirectional search requires non-negative edge weights.");
+    }
+    if (start == end) {
+        return {0, {start}};
+    }
+    int numVer = graph.getVertexNum();
+    const int INF = std::numeric_limits<int>::max();
+    std::vector<int> distance[2] = {std::vector<int>(numVer, INF), std::vector<int>(numVer, INF)};
+    std::vector<int> parent[2] = {std::vector<int>(numVer, -1), std::vector<int>(numVer, -1)};
+    distance[0][start] = 0;
+    distance[1][end] = 0;
+    long long best = INF;
+    int meetFrom = -1, meetTo = -1;
+
+    // Scans the edges of u on one side: side 0 follows out-edges from start,
+    // side 1 in-edges towards end. Returns the vertices labelled for the first time.
+    auto scan = [&](int side, int u, std::vector<int>* fresh, IndexedDaryHeap<4>* heap) {
+        std::vector<int>& own = distance[side];
+        const std::vector<int>& other = distance[1 - side];
+        int pos = side == 0 ? graph.edgeBegin(u) : graph.inEdgeBegin(u), v, weight;
+        while (side == 0 ? graph.nextEdge(u, pos, v, weight) : graph.nextInEdge(u, pos, v, weight)) {
+            if (other[v] != INF && static_cast<long long>(own[u]) + weight + other[v] < best) {
+                best = static_cast<long long>(own[u]) + weight + other[v];
+                meetFrom = side == 0 ? u : v;
+                meetTo = side == 0 ? v : u;
+            }
+            if (own[u] + weight < own[v]) {
+                if (fresh != nullptr && own[v] == INF) {
+                    fresh->push_back(v);
+                }
+                own[v] = own[u] + weight;
+                parent[side][v] = u;
+                if (heap != nullptr) {
+                    heap->update(v, own[v]);
+                }
+            }
+        }
+    };
+
+    if (!graph.isGraphWeighted()) {
+        std::vector<int> frontier[2] = {std::vector<int>(1, start), std::vector<int>(1, end)};
+        std::vector<int> next;
+        while (!frontier[0].empty() && !frontier[1].empty() && best == INF) {
+            int side = frontier[0].size() <= frontier[1].size() ? 0 : 1;
+            next.clear();
+            for (int u : frontier[side]) {
+                scan(side, u, &next, nullptr);
+            }
+            frontier[side].swap(next);
+        }
+    } else {
+        IndexedDaryHeap<4> heap[2] = {IndexedDaryHeap<4>(numVer), IndexedDaryHeap<4>(numVer)};
+        heap[0].update(start, 0);
+        heap[1].update(end, 0);
+        while (true) {
+            long long top0 = heap[0].empty() ? INF : heap[0].minKey();
+            long long top1 = heap[1].empty() ? INF : heap[1].minKey();
+            if (top0 == INF || top1 == INF || top0 + top1 >= best) {
+                break;
+            }
+            int side = top0 <= top1 ? 0 : 1;
+            scan(side, heap[side].pop(), nullptr, &heap[side]);
+        }
+    }
+
+    if (best == INF) {
+        return {-1, {}}; // No path found
+    }
+    return {static_cast<int>(best), joinPaths(parent[0], meetFrom, parent[1], meetTo)};
+}
+
+// Dijkstra over out-edges (or in-edges when reverse is set) from root to every vertex.
+static std::vector<int> distancesFrom(const Graph& graph, int root, bool reverse) {
+    int numVer = graph.getVertexNum();
+    std::vector<int> distance(numVer, std::numeric_limits<int>::max());
+    IndexedDaryHeap<4> heap(numVer);
+    distance[root] = 0;
+    heap.update(root, 0);
+    while (!heap.empty()) {
+        int u = heap.pop();
+        int pos = reverse ? graph.inEdgeBegin(u) : graph.edgeBegin(u), v, weight;
+        while (reverse ? graph.nextInEdge(u, pos, v, weight) : graph.nextEdge(u, pos, v, weight)) {
+            if (distance[u] + weight < distance[v]) {
+                distance[v] = distance[u] + weight;
+                heap.update(v, distance[v]);
+            }
+        }
+    }
+    return distance;
+}
+
+// Function to pick landmarks for goal-directed search
+/**
+ * Picks landmarks by farthest-point selection: each new landmark is the
+ * vertex farthest from the ones already chosen, preferring vertices none of
+ * them reaches, and stores its distances to and from every vertex.
+ *
+ * @param graph The graph.
+ * @param count The number of landmarks; more give tighter bounds at 2 ints per vertex each.
+ * @return The landmarks and their distance tables.
+ * @throws std::invalid_argument If the graph has negative weights.
+ */
+Algorithms::Landmarks Algorithms::selectLandmarks(const Graph& graph, int count) {
+    if (graph.isGraphNegWeighted()) {
+        throw std::invalid_argument("Landmarks require non-negative edge weights.");
+    }
+    int numVer = graph.getVertexNum();
+    const int INF = std::numeric_limits<int>::max();
+    Landmarks landmarks;
+    count = std::min(count, numVer);
+    // Distance from the nearest landmark chosen so far; the first pick is the
+    // vertex farthest from vertex 0
+    std::vector<int> nearest = count > 0 ? distancesFrom(graph, 0, false) : std::vector<int>();
+    for (int i = 0; i < count; ++i) {
+        int pick = -1;
+        for (int v = 0; v < numVer; ++v) {
+            if (nearest[v] != 0 && (pick == -1 || nearest[v] > nearest[pick])) {
+                pick = v;
+            }
+        }
+        if (pick == -1) {
+            break;
+        }
+        landmarks.vertices.push_back(pick);
+        landmarks.from.push_back(distancesFrom(graph, pick, false));
+        landmarks.to.push_back(graph.isGraphDirected() ? distancesFrom(graph, pick, true) : landmarks.from.back());
+        if (i == 0) {
+            nearest.assign(numVer, INF);
+        }
+        for (int v = 0; v < numVer; ++v) {
+            nearest[v] = std::min(nearest[v], landmarks.from.back()[v]);
+        }
+    }
+    return landmarks;
+}
+
+/**
+ * Lower bound on the distance from v to target by the triangle inequality:
+ * d(L, target) - d(L, v) and d(v, L) - d(target, L) for every landmark L.
+ *
+ * @param v The vertex.
+ * @param target The target vertex.
+ * @return A lower bound that never overestimates, 0 when nothing is known.
+ */
+int Algorithms::Landmarks::lowerBound(int v, int target) const {
+    const int INF = std::numeric_limits<int>::max();
+    int bound = 0;
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        if (from[i][v] != INF && from[i][target] != INF) {
+            bound = std::max(bound, from[i][target] - from[i][v]);
+        }
+        if (to[i][v] != INF && to[i][target] != INF) {
+            bound = std::max(bound, to[i][v] - to[i][target]);
+        }
+    }
+    return bound;
+}
+
+// Function to find the shortest path with A* search
+/**
+ * Finds the shortest path with A*: Dijkstra ordered by distance so far plus a
+ * lower bound on the distance left, so the search heads towards end and
+ * settles far fewer vertices. A vertex whose distance improves after it was
+ * settled is searched again, so bounds that never overestimate give the
+ * shortest path even when they are not consistent.
+ *
+ * @param graph The graph.
+ * @param start The start vertex.
+ * @param end The end vertex.
+ * @param lowerBound Called as lowerBound(v); must not exceed the distance from v to end.
+ * @return A pair containing the shortest path length and the path itself.
+ * @throws std::invalid_argument If the graph has negative weights.
+ */
+std::pair<int, std::vector<int>> Algorithms::aStarShortestPath(const Graph& graph, int start, int end, const std::function<int(int)>& lowerBound) {
+    if (graph.isGraphNegWeighted()) {
+        throw std::invalid_argument("A* search requires non-negative edge weights.");
+    }
+    int numVer = graph.getVertexNum();
+    const int INF = std::numeric_limits<int>::max();
+    std::vector<int> distance(numVer, INF);
+    std::vector<int> parent(numVer, -1);
+    IndexedDaryHeap<4> heap(numVer);
+    distance[start] = 0;
+    heap.update(start, lowerBound(start));
+
+    while (!heap.empty()) {
+        int u = heap.pop();
+        if (u == end) {
+            break;
+        }
+        int pos = graph.edgeBegin(u), v, weight;
+        while (graph.nextEdge(u, pos, v, weight)) {
+            if (distance[u] + weight < distance[v]) {
+                distance[v] = distance[u] + weight;
+                parent[v] = u;
+                heap.update(v, distance[v] + lowerBound(v));
+            }
+        }
+    }
+
+    if (distance[end] == INF) {
+        return {-1, {}}; // No path found
+    }
+
+    std::vector<int> path;
+    tracePath(parent, end, path);
+    return {distance[end], path}; // Shortest path length and path
+}
+
+/**
+ * Finds the shortest path with A* guided by landmark (ALT) lower bounds.
+ *
+ * @param graph The graph.
+ * @param start The start vertex.
+ * @param end The end vertex.
+ * @param landmarks Landmarks from selectLandmarks for this graph.
+ * @return A pair containing the shortest path length and the path itself.
+ * @throws std::invalid_argument If the graph has negative weights.
+ */
+std::pair<int, std::vector<int>> Algorithms::aStarShortestPath(const Graph& graph, int start, int end, const Landmarks& landmarks) {
+    return aStarShortestPath(graph, start, end, [&](int v) { return landmarks.lowerBound(v, end); });
+}
+
+// Function to find the shortest path using Bellman-Ford algorithm
+/**
+ * Finds the shortest path with the queue-based Bellman-Ford (see relaxFromSources).
+ *
+ * @param g The graph.
+ * @param start The start vertex.
+ * @param end The end vertex.
+ * @param path Receives the path.
+ * @return The status and the path length.
+ */
+static Algorithms::PathResult bellmanFordSearch(const Graph& g, int start, int end, std::vector<int>& path) {
+    int vertexNum = g.getVertexNum();
+    const int INF = std::numeric_limits<int>::max();
+    std::vector<int> dist(vertexNum, INF);
+    std::vector<int> parent(vertexNum, -1);
+    dist[start] = 0;
+
+    // Relax edges until nothing changes, stopping at a negative weight cycle
+    if (relaxFromSources(g, dist, parent) != -1) {
+        return {Algorithms::PathStatus::NegativeCycle, -1};
+    }
+    if (dist[end] == INF) {
+        return {Algorithms::PathStatus::NoPath, -1};
+    }
+    tracePath(parent, end, path);
+    return {Algorithms::PathStatus::Found, dist[end]};
+}
+
+// Formats a structured result the way the string queries report it.
+static std::string formatResult(const Algorithms::PathResult& result, const std::vector<int>& path) {
+    if (result.status == Algorithms::PathStatus::Found) {
+        return Algorithms::formatPath(path);
+    }
+    return result.status == Algorithms::PathStatus::NegativeCycle ? "Negative cycle detected" : "-1";
+}
+
+static bool isVertex(const Graph& graph, int v) {
+    return v >= 0 && v < graph.getVertexNum();
+}
+
+/**
+ * Finds the shortest path using the Bellman-Ford algorithm.
+ *
+ * @param g The graph.
+ * @param start The start vertex.
+ * @param end The end vertex.
+ * @return A string representing the path or a negative cycle message.
+ */
+string Algorithms::bellmanFordShortestPath(const Graph &g, int start, int end) {
+    std::vector<int> path;
+    if (!isVertex(g, start) || !isVertex(g, end)) {
+        return "-1";
+    }
+    return formatResult(bellmanFordSearch(g, start, end, path), path);
+}
+
+// Function to find the shortest path based on graph type
+/**
+ * Finds the shortest path with the engine that fits the graph: BFS when it is
+ * unweighted, Dijkstra (or delta-stepping on large graphs with a multi-threaded
+ * pool) when the weights are non-negative, Bellman-Ford otherwise.
+ *
+ * @param graph The graph.
+ * @param start The start vertex.
+ * @param end The end vertex.
+ * @param path Receives the path, start first; cleared unless one is found.
+ * @return The status and, when a path is found, its length.
+ */
+Algorithms::PathResult Algorithms::findShortestPath(const Graph& graph, int start, int end, std::vector<int>& path) {
+    path.clear();
+    if (!isVertex(graph, start) || !isVertex(graph, end)) {
+        return {PathStatus::InvalidVertex, -1};
+    }
+    if (graph.isGraphNegWeighted()) {
+        return bellmanFordSearch(graph, start, end, path);
+    }
+    if (!graph.isGraphWeighted()) {
+        BreadthFirstSearch search(graph);
+        search.run(start, std::vector<int>(1, end));
+        if (search.distance[end] == -1) {
+            return {PathStatus::NoPath, -1};
+        }
+        tracePath(search.parent, end, path);
+        return {PathStatus::Found, search.distance[end]};
+    }
+
+    int numVer = graph.getVertexNum();
+    std::vector<int> distance, parent;
+    if (ThreadPool::shared().getThreadCount() > 1 && graph.getNumberOfEdges() >= deltaSteppingMinEdges) {
+        deltaSteppingSearch(graph, start, std::vector<int>(1, end), 0, distance, parent);
+    } else {
+        distance.assign(numVer, std::numeric_limits<int>::max());
+        parent.assign(numVer, -1);
+        IndexedDaryHeap<4> heap(numVer);
+        dijkstraSearch(graph, start, std::vector<int>(1, end), heap, distance, parent);
+    }
+    if (distance[end] == std::numeric_limits<int>::max()) {
+        return {PathStatus::NoPath, -1};
+    }
+    tracePath(parent, end, path);
+    return {PathStatus::Found, distance[end]};
+}
+
+/**
+ * Finds the shortest path based on the graph type (unweighted, weighted, or
+ * negative weighted) and formats it (see findShortestPath).
+ *
+ * @param graph The graph.
+ * @param start The start vertex.
+ * @param end The end vertex.
+ * @return A string representing the path, "Negative cycle detected", or "-1" if no path is found.
+ */
+std::string Algorithms::shortestPath(const Graph& graph, int start, int end) {
+    std::vector<int> path;
+    PathResult result = findShortestPath(graph, start, end, path);
+    return formatResult(result, path);
+}
+
+/**
+ * @param v A vertex.
+ * @return True if v was reached from the source.
+ */
+bool Algorithms::ShortestPathTree::reaches(int v) const {
+    return distance[v] != std::numeric_limits<int>::max();
+}
+
+/**
+ * Follows the parent links back from v.
+ *
+ * @param v The end vertex.
+ * @return The vertices from the source to v, or an empty path if v was not reached.
+ */
+std::vector<int> Algorithms::ShortestPathTree::pathTo(int v) const {
+    std::vector<int> path;
+    if (!reaches(v)) {
+        return path;
+    }
+    for (; v != -1; v = parent[v]) {
+        path.push_back(v);
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+// Checks that every vertex of a batch query exists
+static void checkVertices(const Graph& graph, const std::vector<int>& vertices) {
+    for (int v : vertices) {
+        if (v < 0 || v >= graph.getVertexNum()) {
+            throw std::invalid_argument("Vertex index out of range.");
+        }
+    }
+}
+
+// One search of shortestPathTree, with the vertices already checked
+static Algorithms::ShortestPathTree searchTree(const Graph& graph, int source, const std::vector<int>& targets) {
+    int numVer = graph.getVertexNum();
+    const int INF = std::numeric_limits<int>::max();
+    Algorithms::ShortestPathTree tree;
+    tree.source = source;
+    tree.negativeCycle = false;
+    tree.parent.assign(numVer, -1);
+
+    if (graph.isGraphNegWeighted()) {
+        tree.distance.assign(numVer, INF);
+        tree.distance[source] = 0;
+        tree.negativeCycle = Algorithms::relaxEdges(graph, tree.distance, tree.parent);
+    } else if (graph.isGraphWeighted()) {
+        tree.distance.assign(numVer, INF);
+        IndexedDaryHeap<4> heap(numVer);
+        dijkstraSearch(graph, source, targets, heap, tree.distance, tree.parent);
+    } else {
+        BreadthFirstSearch search(graph);
+        search.run(source, targets);
+        tree.distance.swap(search.distance);
+        tree.parent.swap(search.parent);
+        std::replace(tree.distance.begin(), tree.distance.end(), -1, INF);
+    }
+    return tree;
+}
+
+// Function to compute the shortest paths from one source to many targets
+/**
+ * Computes shortest paths from one source with a single search, chosen by the
+ * graph type as in shortestPath: BFS, Dijkstra, or Bellman-Ford when weights
+ * can be negative. Paths to any number of targets are then read from the tree.
+ *
+ * @param graph The graph.
+ * @param source The source vertex.
+ * @param targets The vertices of interest. The search stops once all of them are final, so only
+ *                their entries are guaranteed shortest; empty to compute the whole tree.
+ * @return The distances and parent tree from the source.
+ * @throws std::invalid_argument If a vertex is out of range.
+ */
+Algorithms::ShortestPathTree Algorithms::shortestPathTree(const Graph& graph, int source, const std::vector<int>& targets) {
+    checkVertices(graph, std::vector<int>(1, source));
+    checkVertices(graph, targets);
+    return searchTree(graph, source, targets);
+}
+
+// Function to compute the shortest paths from many sources to many targets
+/**
+ * Computes one shortestPathTree per source. The searches are independent and
+ * are spread over the shared thread pool.
+ *
+ * @param graph The graph.
+ * @param sources The source vertices.
+ * @param targets The vertices of interest, shared by all sources; empty to compute whole trees.
+ * @return One tree per source, in the order of sources.
+ * @throws std::invalid_argument If a vertex is out of range.
+ */
+std::vector<Algorithms::ShortestPathTree> Algorithms::shortestPathTrees(const Graph& graph, const std::vector<int>& sources, const std::vector<int>& targets) {
+    checkVertices(graph, sources);
+    checkVertices(graph, targets);
+    // Fill the shared property caches before the searches read them concurrently
+    graph.isGraphNegWeighted();
+    std::vector<ShortestPathTree> trees(sources.size());
+    long long searchWork = graph.getVertexNum() + static_cast<long long>(graph.getNumberOfEdges());
+    ThreadPool::shared().parallelFor(0, static_cast<int>(sources.size()), searchWork, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            trees[i] = searchTree(graph, sources[i], targets);
+        }
+    });
+    return trees;
+}
+
+// Relaxation kernels for the all-pairs engines. Each lowers
+// dist[0..count) to a + via[0..count) where that is shorter, recording hop as
+// the first step of the improved paths. Unreachable cells hold INT_MAX and are
+// never used as a via.
+
+static void relaxRow(int* dist, int* next, const int* via, int a, int hop, int count) {
+    const int INF = std::numeric_limits<int>::max();
+    for (int j = 0; j < count; ++j) {
+        if (via[j] != INF && a + via[j] < dist[j]) {
+            dist[j] = a + via[j];
+            next[j] = hop;
+        }
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+static void relaxRowAvx2(int* dist, int* next, const int* via, int a, int hop, int count) {
+    const __m256i inf = _mm256_set1_epi32(std::numeric_limits<int>::max());
+    const __m256i base = _mm256_set1_epi32(a);
+    const __m256i hops = _mm256_set1_epi32(hop);
+    int j = 0;
+    for (; j + 8 <= count; j += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(via + j));
+        __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dist + j));
+        __m256i sum = _mm256_add_epi32(base, v);
+        __m256i better = _mm256_andnot_si256(_mm256_cmpeq_epi32(v, inf), _mm256_cmpgt_epi32(d, sum));
+        if (_mm256_testz_si256(better, better)) {
+            continue;
+        }
+        __m256i n = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(next + j));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dist + j), _mm256_blendv_epi8(d, sum, better));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(next + j), _mm256_blendv_epi8(n, hops, better));
+    }
+    relaxRow(dist + j, next + j, via + j, a, hop, count - j);
+}
+#endif
+
+typedef void (*RelaxKernel)(int*, int*, const int*, int, int, int);
+
+// Picks the AVX2 kernel once, when the CPU running the program supports it.
+static RelaxKernel relaxKernel() {
+#if defined(__x86_64__) || defined(__i386__)
+    static const RelaxKernel kernel = __builtin_cpu_supports("avx2") ? relaxRowAvx2 : relaxRow;
+    return kernel;
+#else
+    return relaxRow;
+#endif
+}
+
 /**
- * Relaxes the edges of the graph to update distances and parents.
- *
- * @param g The graph.
- * @param dist Distance vector.
- * @param parent Parent vector.
+ * Floyd-Warshall restricted to one tile: for each k in [kBegin, kEnd), in
+ * order, relaxes rows [iBegin, iEnd) over columns [jBegin, jEnd) through k.
+ * dist and next are n x n, row-major.
  */
-void Algorithms::relaxEdges(const Graph &g, std::vector<int> &dist, std::vector<int> &parent) {
-    int V = g.getVertexNum();
-    std::vector<std::vector<int>> matrix = g.getGraph();
+static void relaxTile(int* dist, int* next, int n, int iBegin, int iEnd, int jBegin, int jEnd, int kBegin, int kEnd) {
     const int INF = std::numeric_limits<int>::max();
-
-    for (int i = 1; i <= V - 1; ++i) {
-        for (int u = 0; u < V; ++u) {
-            for (int v = 0; v < V; ++v) {
-                if (matrix[u][v] != 0 && dist[u] != INF && dist[u] + matrix[u][v] < dist[v]) {
-                    dist[v] = dist[u] + matrix[u][v];
-                    parent[v] = u;
-                }
+    RelaxKernel kernel = relaxKernel();
+    for (int k = kBegin; k < kEnd; ++k) {
+        const int* via = dist + static_cast<size_t>(k) * n + jBegin;
+        for (int i = iBegin; i < iEnd; ++i) {
+            size_t row = static_cast<size_t>(i) * n;
+            int a = dist[row + k];
+            if (a != INF) {
+                kernel(dist + row + jBegin, next + row + jBegin, via, a, next[row + k], jEnd - jBegin);
             }
         }
     }
 }
 
-
-
-// Function to find the shortest path in an unweighted graph using BFS
 /**
- * Finds the shortest path in an unweighted graph using BFS.
- *
- * @param graph The graph.
- * @param start The start vertex.
- * @param end The end vertex.
- * @return A pair containing the shortest path length and the path itself.
+ * Cache-blocked Floyd-Warshall over 256 x 256 tiles, sized for L2. For each
+ * diagonal tile: the tile itself, then the tiles sharing its rows or columns,
+ * then all the others. The last two phases only read finished tiles, so their tiles are
+ * spread over the shared thread pool.
  */
-std::pair<int, std::vector<int>> Algorithms::bfsShortestPath(const Graph& graph, int start, int end) {
-    int numVer = graph.getVertexNum();
-    std::vector<int> distance(numVer, -1);
-    std::vector<int> parent(numVer, -1);
-    std::queue<int> q;
+static void blockedFloydWarshall(int* dist, int* next, int n) {
+    const int tile = 256;
+    int tiles = (n + tile - 1) / tile;
+    ThreadPool& pool = ThreadPool::shared();
+    long long tileWork = static_cast<long long>(tile) * tile * tile;
+    for (int kt = 0; kt < tiles; ++kt) {
+        int kBegin = kt * tile, kEnd = std::min(n, kBegin + tile);
+        relaxTile(dist, next, n, kBegin, kEnd, kBegin, kEnd, kBegin, kEnd);
 
-    distance[start] = 0;
-    q.push(start);
-
-    while (!q.empty()) {
-        int v = q.front();
-        q.pop();
-
-        for (int i = 0; i < numVer; ++i) {
-            if (graph.getGraph()[v][i] != 0 && distance[i] == -1) {
-                distance[i] = distance[v] + 1;
-                parent[i] = v;
-                q.push(i);
+        // Tiles in the pivot row (t < tiles) and in the pivot column
+        pool.parallelFor(0, 2 * tiles, tileWork, [&](int begin, int end) {
+            for (int t = begin; t < end; ++t) {
+                int other = t % tiles;
+                if (other == kt) {
+                    continue;
+                }
+                int oBegin = other * tile, oEnd = std::min(n, oBegin + tile);
+                if (t < tiles) {
+                    relaxTile(dist, next, n, kBegin, kEnd, oBegin, oEnd, kBegin, kEnd);
+                } else {
+                    relaxTile(dist, next, n, oBegin, oEnd, kBegin, kEnd, kBegin, kEnd);
+                }
             }
-        }
-    }
-
-    if (distance[end] == -1) {
-        return {-1, {}}; // No path found
-    }
+        });
 
-    // Reconstruct the path
-    std::vector<int> path;
-    for (int v = end; v != -1; v = parent[v]) {
-        path.push_back(v);
+        pool.parallelFor(0, tiles, tileWork * tiles, [&](int begin, int end) {
+            for (int it = begin; it < end; ++it) {
+                if (it == kt) {
+                    continue;
+                }
+                int iBegin = it * tile, iEnd = std::min(n, iBegin + tile);
+                for (int jt = 0; jt < tiles; ++jt) {
+                    if (jt != kt) {
+                        relaxTile(dist, next, n, iBegin, iEnd, jt * tile, std::min(n, (jt + 1) * tile), kBegin, kEnd);
+                    }
+                }
+            }
+        });
     }
-    std::reverse(path.begin(), path.end());
-
-    return {distance[end], path}; // Shortest path length and path
 }
 
-// Function to find the shortest path in a weighted graph using Dijkstra's algorithm
 /**
- * Finds the shortest path in a weighted graph using Dijkstra's algorithm.
- *
- * @param graph The graph.
- * @param start The start vertex.
- * @param end The end vertex.
- * @return A pair containing the shortest path length and the path itself.
+ * The (min, +) semiring for blockedProduct: relaxes the result row in place
+ * through every reachable a[i][k], recording the first hop in cNext.
  */
-std::pair<int, std::vector<int>> Algorithms::dijkstraShortestPath(const Graph& graph, int start, int end) {
-    int numVer = graph.getVertexNum();
-    std::vector<int> distance(numVer, std::numeric_limits<int>::max());
-    std::vector<int> parent(numVer, -1);
-    std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>, std::greater<std::pair<int, int>>> pq;
-
-    distance[start] = 0;
-    pq.push({0, start});
-
-    while (!pq.empty()) {
-        int dist = pq.top().first;
-        int v = pq.top().second;
-        pq.pop();
+class MinPlusTiles {
+public:
+    MinPlusTiles(const int* a, const int* aNext, int* c, int* cNext, int n)
+        : a(a), aNext(aNext), c(c), cNext(cNext), n(n), kernel(relaxKernel()) {}
 
-        if (dist > distance[v]) continue;
+    void beginTile(int, int, int, int) {}
 
-        for (int i = 0; i < numVer; ++i) {
-            if (graph.getGraph()[v][i] != 0) {
-                int weight = graph.getGraph()[v][i];
-                if (distance[v] + weight < distance[i]) {
-                    distance[i] = distance[v] + weight;
-                    parent[i] = v;
-                    pq.push({distance[i], i});
-                }
-            }
+    void accumulate(int i, int k, int col, int width) {
+        size_t row = static_cast<size_t>(i) * n;
+        if (a[row + k] != std::numeric_limits<int>::max()) {
+            kernel(c + row + col, cNext + row + col, a + static_cast<size_t>(k) * n + col, a[row + k], aNext[row + k], width);
         }
     }
 
-    if (distance[end] == std::numeric_limits<int>::max()) {
-        return {-1, {}}; // No path found
-    }
+    void endTile(int, int, int, int) {}
 
-    // Reconstruct the path
-    std::vector<int> path;
-    for (int v = end; v != -1; v = parent[v]) {
-        path.push_back(v);
-    }
-    std::reverse(path.begin(), path.end());
+private:
+    const int* a;
+    const int* aNext;
+    int* c;
+    int* cNext;
+    int n;
+    RelaxKernel kernel;
+};
 
-    return {distance[end], path}; // Shortest path length and path
+/**
+ * Min-plus product c = min(c, a (x) a), where c starts as a copy of a: the
+ * shortest paths using at most twice as many edges. Shares the tiling of
+ * Graph::operator* (BlockedProduct.hpp), with the result row blocks split
+ * across threads.
+ *
+ * @return True if any distance changed.
+ */
+static bool minPlusSquare(const int* a, const int* aNext, int* c, int* cNext, int n) {
+    std::atomic<bool> changed(false);
+    int blocks = (n + productRowBlock - 1) / productRowBlock;
+    ThreadPool::shared().parallelFor(0, blocks, static_cast<long long>(productRowBlock) * n * n, [&](int begin, int end) {
+        MinPlusTiles tiles(a, aNext, c, cNext, n);
+        for (int block = begin; block < end; ++block) {
+            int ii = block * productRowBlock, rows = std::min(productRowBlock, n - ii);
+            blockedProduct(n, n, ii, ii + rows, tiles);
+            size_t first = static_cast<size_t>(ii) * n, last = first + static_cast<size_t>(rows) * n;
+            if (!std::equal(c + first, c + last, a + first)) {
+                changed = true;
+            }
+        }
+    });
+    return changed;
 }
 
-// Function to find the shortest path using Bellman-Ford algorithm
+// Function to compute the shortest paths between all pairs of vertices
 /**
- * Finds the shortest path using the Bellman-Ford algorithm.
+ * Computes the shortest distance and the first hop between every pair of
+ * vertices, in O(V²) memory. FloydWarshall runs a cache-blocked, multithreaded
+ * Floyd-Warshall in O(V³). MinPlus squares the distance matrix with min-plus
+ * products until it stops changing, O(V³ log V) at worst.
  *
- * @param g The graph.
- * @param start The start vertex.
- * @param end The end vertex.
- * @return A string representing the path or a negative cycle message.
+ * @param graph The graph.
+ * @param method AllPairsMethod::FloydWarshall or AllPairsMethod::MinPlus.
+ * @return The distance and next-hop matrices.
  */
-string Algorithms::bellmanFordShortestPath(const Graph &g, int start, int end) {
-    std::stringstream ss;
-    int vertexNum = g.getVertexNum();
+Algorithms::AllPairsPaths Algorithms::allPairsShortestPaths(const Graph& graph, AllPairsMethod method) {
+    int n = graph.getVertexNum();
     const int INF = std::numeric_limits<int>::max();
-
-    if (vertexNum == 0 || start >= vertexNum || end >= vertexNum) {
-        return "-1";
-    }
-
-    std::vector<int> dist(vertexNum, INF);
-    std::vector<int> parent(vertexNum, -1);
-    dist[start] = 0;
-
-    // Relax all edges
-    relaxEdges(g, dist, parent);
-
-    // Check for negative weight cycles
-    for (int u = 0; u < vertexNum; ++u) {
-        for (int v = 0; v < vertexNum; ++v) {
-            int weight = g.getGraph()[u][v];
-            if (weight != 0 && dist[u] != INF && dist[u] + weight < dist[v]) {
-                // Negative weight cycle found
-                return "Negative cycle detected";
+    AllPairsPaths result;
+    result.numVer = n;
+    result.negativeCycle = false;
+    result.distance.assign(static_cast<size_t>(n) * n, INF);
+    result.next.assign(static_cast<size_t>(n) * n, -1);
+    for (int u = 0; u < n; ++u) {
+        size_t row = static_cast<size_t>(u) * n;
+        result.distance[row + u] = 0;
+        int pos = graph.edgeBegin(u), v, weight;
+        while (graph.nextEdge(u, pos, v, weight)) {
+            if (v != u || weight < 0) {
+                result.distance[row + v] = weight;
+                result.next[row + v] = v;
             }
         }
     }
 
-    if (dist[end] == INF) {
-        return "-1"; // No path found
-    }
-
-    // Reconstruct the path
-    std::stack<int> path;
-    int currVertex = end;
-    while (currVertex != -1) {
-        path.push(currVertex);
-        currVertex = parent[currVertex];
+    if (method == AllPairsMethod::MinPlus) {
+        std::vector<int> distance(result.distance), next(result.next);
+        // Each square doubles the number of edges a path may use; once it
+        // covers V edges, every shortest path and every simple cycle is in
+        for (long long edges = 1; edges < n; edges *= 2) {
+            bool changed = minPlusSquare(result.distance.data(), result.next.data(), distance.data(), next.data(), n);
+            result.distance.swap(distance);
+            result.next.swap(next);
+            if (!changed) {
+                break;
+            }
+            distance = result.distance;
+            next = result.next;
+        }
+    } else {
+        blockedFloydWarshall(result.distance.data(), result.next.data(), n);
     }
 
-    // Print the path
-    while (!path.empty()) {
-        ss << path.top();
-        path.pop();
-        if (!path.empty()) {
-            ss << "->";
+    for (int v = 0; v < n; ++v) {
+        if (result.distance[static_cast<size_t>(v) * n + v] < 0) {
+            result.negativeCycle = true;
         }
     }
-    return ss.str();
+    return result;
+}
+
+/**
+ * @param from The start vertex.
+ * @param to The end vertex.
+ * @return The shortest distance, or std::numeric_limits<int>::max() if to is unreachable.
+ */
+int Algorithms::AllPairsPaths::getDistance(int from, int to) const {
+    return distance[static_cast<size_t>(from) * numVer + to];
 }
 
-// Function to find the shortest path based on graph type
 /**
- * Finds the shortest path based on the graph type (unweighted, weighted, or negative weighted).
+ * Follows the next-hop matrix from one vertex to another.
  *
- * @param graph The graph.
- * @param start The start vertex.
- * @param end The end vertex.
- * @return A string representing the path or "-1" if no path is found.
+ * @param from The start vertex.
+ * @param to The end vertex.
+ * @return The vertices from from to to, or an empty path if to is unreachable or a negative cycle makes the path undefined.
  */
-std::string Algorithms::shortestPath(Graph& graph, int start, int end) {
-    std::pair<int, std::vector<int>> result;
-    if (graph.isGraphNegWeighted()){
-        return bellmanFordShortestPath(graph,start,end);
-    }
-    if (graph.isGraphWeighted()) {
-        result = dijkstraShortestPath(graph, start, end);
-    } else {
-        result = bfsShortestPath(graph, start, end);
+std::vector<int> Algorithms::AllPairsPaths::path(int from, int to) const {
+    std::vector<int> vertices;
+    if (getDistance(from, to) == std::numeric_limits<int>::max()) {
+        return vertices;
     }
-
-    if (result.first == -1) {
-        return "-1";
+    vertices.push_back(from);
+    while (from != to) {
+        from = next[static_cast<size_t>(from) * numVer + to];
+        if (static_cast<int>(vertices.size()) > numVer) {
+            return std::vector<int>();
+        }
+        vertices.push_back(from);
     }
-
-    return formatPath(result.second);
+    return vertices;
 }
 
 // Helper function to format the path
@@ -301,25 +1882,67 @@ std::string Algorithms::formatPath(const std::vector<int>& path) {
     return formattedPath;
 }
 
-void Algorithms::printCycle(const std::vector<int>& parent, int start, int end) {
-    std::vector<int> cycle;
+// Writes the cycle closed by the edge start -> end, where end is an ancestor of
+// start in the parent tree, as end ... start end.
+void Algorithms::traceCycle(const std::vector<int>& parent, int start, int end, std::vector<int>& cycle) {
+    cycle.clear();
     cycle.push_back(end);
     for (int v = start; v != end; v = parent[v]) {
         cycle.push_back(v);
     }
     cycle.push_back(end);
-
     std::reverse(cycle.begin(), cycle.end());
-    cout << "The cycle is: ";
+}
+
+static void printCycleVertices(const std::vector<int>& cycle, std::ostream& out) {
+    out << "The cycle is: ";
     for (int v : cycle) {
-        cout << v << " ";
+        out << v << " ";
+    }
+    out << "\n";
+}
+
+void Algorithms::printCycle(const std::vector<int>& parent, int start, int end, std::ostream& out) {
+    std::vector<int> cycle;
+    traceCycle(parent, start, end, cycle);
+    printCycleVertices(cycle, out);
+}
+
+/**
+ * Runs the cycle search from v and copies its state back into the caller's vectors.
+ *
+ * @param v The start vertex.
+ * @param graph The graph.
+ * @param directed True to treat every edge as one-way.
+ * @param visited The visited vector.
+ * @param parentVec The parent vector.
+ * @return True if a cycle is detected, false otherwise.
+ */
+static bool findCycleFrom(int v, const Graph& graph, bool directed, std::vector<bool>& visited, std::vector<int>& parentVec) {
+    DepthFirstSearch search(graph);
+    for (size_t i = 0; i < visited.size(); ++i) {
+        if (visited[i]) {
+            search.markVisited(static_cast<int>(i));
+        }
+    }
+    std::vector<int> cycle;
+    Algorithms::CycleVisitor visitor;
+    Algorithms::CycleDetector<Algorithms::CycleVisitor> detector(search, directed, cycle, visitor);
+    bool found = search.run(v, detector);
+    for (size_t i = 0; i < visited.size(); ++i) {
+        if (search.isVisited(static_cast<int>(i)) && !visited[i]) {
+            visited[i] = true;
+            parentVec[i] = search.getParents()[i];
+        }
     }
-    cout << endl;
+    return found;
 }
 
 // DFS helper function for undirected graph
 /**
- * DFS utility to detect a cycle in an undirected graph.
+ * DFS utility to detect a cycle in an undirected graph. Runs iteratively.
+ * Deprecated: every call costs O(V) to set up; use findCycle to search the
+ * whole graph.
  *
  * @param v The current vertex.
  * @param parent The parent vertex.
@@ -329,84 +1952,57 @@ void Algorithms::printCycle(const std::vector<int>& parent, int start, int end)
  * @return True if a cycle is detected, false otherwise.
  */
 bool Algorithms::DFSUtilUndirected(int v, int parent, const Graph& graph, std::vector<bool>& visited, std::vector<int>& parentVec) {
-    visited[v] = true;
-    parentVec[v] = parent; // Set the parent of the current node
-
-    for (int u = 0; u < graph.getVertexNum(); ++u) {
-        if (graph.getGraph()[v][u] != 0) {
-            if (!visited[u]) {
-                if (DFSUtilUndirected(u, v, graph, visited, parentVec)) {
-                    return true;
-                }
-            } else if (u != parent) {
-                printCycle(parentVec, v, u);
-                return true;
-            }
-        }
-    }
-    return false;
+    bool found = findCycleFrom(v, graph, false, visited, parentVec);
+    parentVec[v] = parent;
+    return found;
 }
 
 
 // DFS helper function for directed graph
 /**
- * DFS utility to detect a cycle in a directed graph.
+ * DFS utility to detect a cycle in a directed graph. Runs iteratively; the
+ * search tracks its own DFS path, so no recursion stack vector is taken.
+ * Deprecated: every call costs O(V) to set up; use findCycle to search the
+ * whole graph.
  *
  * @param v The current vertex.
  * @param graph The graph.
  * @param visited The visited vector.
- * @param recStack The recursion stack vector.
  * @param parentVec The parent vector.
  * @return True if a cycle is detected, false otherwise.
  */
-bool Algorithms::DFSUtilDirected(int v, const Graph& graph, std::vector<bool>& visited, std::vector<bool>& recStack, std::vector<int>& parentVec) {
-    visited[v] = true;
-    recStack[v] = true;
-
-    for (int u = 0; u < graph.getVertexNum(); ++u) {
-        if (graph.getGraph()[v][u] != 0) {
-            if (!visited[u]) {
-                parentVec[u] = v;
-                if (DFSUtilDirected(u, graph, visited, recStack, parentVec)) {
-                    return true;
-                }
-            } else if (recStack[u]) {
-                parentVec[v] = u; // Update the parent to reflect the cycle
-                printCycle(parentVec, v, u);
-                return true;
-            }
-        }
-    }
-    recStack[v] = false;
-    return false;
+bool Algorithms::DFSUtilDirected(int v, const Graph& graph, std::vector<bool>& visited, std::vector<int>& parentVec) {
+    return findCycleFrom(v, graph, true, visited, parentVec);
+}
+
+/**
+ * Finds a cycle with one iterative DFS over the whole graph. In an undirected
+ * graph an edge is not a cycle with itself, so the cycle has at least 3 vertices.
+ *
+ * @param graph The graph.
+ * @param cycle Receives the cycle as v0 v1 ... v0, following the edges; cleared if there is none.
+ * @return True if the graph contains a cycle.
+ */
+bool Algorithms::findCycle(const Graph& graph, std::vector<int>& cycle) {
+    CycleVisitor visitor;
+    return findCycle(graph, cycle, visitor);
 }
 
 // Main function to detect and print a cycle
-string Algorithms::isContainsCycle(const Graph& graph) {
-    int numVer = graph.getVertexNum();
-    std::vector<bool> visited(numVer, false);
-    std::vector<int> parentVec(numVer, -1);
-    Graph g1;
-    g1.loadGraph(graph.getGraph());
-    if (g1.isGraphDirected()) {
-        std::vector<bool> recStack(numVer, false);
-        for (int v = 0; v < numVer; ++v) {
-            if (!visited[v]) {
-                if (Algorithms::DFSUtilDirected(v, graph, visited, recStack, parentVec)) {
-                    return "";
-                }
-            }
-        }
-    } else {
-        for (int v = 0; v < numVer; ++v) {
-            if (!visited[v]) {
-                if (Algorithms::DFSUtilUndirected(v, -1, graph, visited, parentVec)) {
-                    return "";
-                }
-            }
-        }
+/**
+ * Detects a cycle (see findCycle) and prints it.
+ *
+ * @param graph The graph.
+ * @param out The stream the cycle is printed to.
+ * @return An empty string if a cycle exists, "0" otherwise.
+ */
+string Algorithms::isContainsCycle(const Graph& graph, std::ostream& out) {
+    std::vector<int> cycle;
+    if (!findCycle(graph, cycle)) {
+        return "0";
     }
-    return "0";
+    printCycleVertices(cycle, out);
+    return "";
 }
 
 // Function to partition the graph into two sets based on colors
@@ -427,9 +2023,156 @@ void Algorithms::partitionGraph(const std::vector<int>& colors, std::vector<int>
     }
 }
 
+// Undirected components with at least this many vertices are searched one at a
+// time with a level-parallel BFS; smaller ones are searched concurrently.
+static const int bipartiteParallelComponent = 1024;
+
+/**
+ * Writes an odd cycle through the edge u - w, whose ends are at the same BFS
+ * level parity, by walking both up the BFS forest to their lowest common
+ * ancestor. Leaves oddCycle empty if they are in different trees, which can
+ * only happen in a directed graph.
+ */
+static void traceOddCycle(const std::vector<int>& distance, const std::vector<int>& parent, int u, int w,
+                          std::vector<int>& oddCycle) {
+    std::vector<int> left(1, u), right(1, w);
+    int a = u, b = w;
+    while (a != b) {
+        if (distance[a] >= distance[b]) {
+            a = parent[a];
+            left.push_back(a);
+        } else {
+            b = parent[b];
+            right.push_back(b);
+        }
+        if (a == -1 || b == -1) {
+            return;
+        }
+    }
+    // left runs u ... ancestor, right w ... ancestor
+    oddCycle.assign(left.rbegin(), left.rend());
+    oddCycle.insert(oddCycle.end(), right.begin(), right.end());
+}
+
+/**
+ * Splits the vertices into two sides with no edge inside either side, if
+ * possible. Each vertex goes to the side of its BFS level's parity; the graph
+ * is bipartite exactly when no edge then joins two vertices of one side.
+ *
+ * With more than one pool thread, an undirected graph is first split into its
+ * connected components (see connectedComponents). Large components are
+ * searched one after another with the level-parallel BFS, small ones
+ * concurrently, one per task. Every search starts at the smallest vertex of
+ * its component, so the sides match a single-threaded run. The edge check
+ * runs on the pool as well.
+ *
+ * @param graph The graph.
+ * @param sides Receives one bit per vertex, (V + 63) / 64 words: bit v is set when v is on the second side.
+ * @param oddCycle Receives an odd cycle when the graph is not bipartite, as v0 v1 ... v0,
+ *                 following edges in either direction; cleared otherwise. In a directed graph
+ *                 it stays empty if the offending edge joins two BFS trees.
+ * @return True if the graph is bipartite.
+ */
+bool Algorithms::bipartition(const Graph& graph, std::vector<uint64_t>& sides, std::vector<int>& oddCycle) {
+    int numVer = graph.getVertexNum();
+    int words = (numVer + 63) / 64;
+    oddCycle.clear();
+
+    BreadthFirstSearch search(graph);
+    if (!graph.isGraphDirected() && ThreadPool::shared().getThreadCount() > 1) {
+        ConnectedComponents components = connectedComponents(graph);
+        std::vector<int> small, large;
+        for (int v = 0, next = 0; v < numVer; ++v) {
+            if (components.component[v] == next) {
+                (components.sizes[next] >= bipartiteParallelComponent ? large : small).push_back(v);
+                ++next;
+            }
+        }
+        search.runEach(small);
+        for (int start : large) {
+            search.run(start, std::vector<int>());
+        }
+    } else {
+        // Search from each vertex that no earlier search reached
+        for (int start = 0; start < numVer; ++start) {
+            if (search.distance[start] == -1) {
+                search.run(start, std::vector<int>());
+            }
+        }
+    }
+    sides.assign(words, 0);
+    for (int v = 0; v < numVer; ++v) {
+        if (search.distance[v] & 1) {
+            sides[v >> 6] |= vertexBit(v);
+        }
+    }
+
+    // For bit-packed graphs the first side is kept as a bitset too, so a row
+    // is checked against its own side 64 neighbours at a time. The smallest
+    // vertex with an edge inside its side is kept, so the witness does not
+    // depend on the thread count.
+    vector<uint64_t> firstSide;
+    if (graph.isBitPacked()) {
+        firstSide.resize(words);
+        for (int w = 0; w < words; ++w) {
+            firstSide[w] = ~sides[w];
+        }
+    }
+    auto side = [&](int v) { return (sides[v >> 6] & vertexBit(v)) != 0; };
+    auto sameSide = [&](int v) {
+        int pos = graph.edgeBegin(v), u, weight;
+        while (graph.nextEdge(v, pos, u, weight)) {
+            if (side(u) == side(v)) {
+                return u;
+            }
+        }
+        return -1;
+    };
+    std::atomic<int> conflict(numVer);
+    long long rowWork = graph.isBitPacked() ? words : 1 + graph.getNumberOfEdges() / std::max(numVer, 1);
+    ThreadPool::shared().parallelFor(0, numVer, rowWork, [&](int begin, int end) {
+        for (int v = begin; v < end && v < conflict.load(std::memory_order_relaxed); ++v) {
+            bool found = false;
+            if (graph.isBitPacked()) {
+                const uint64_t* row = graph.getBitRow(v);
+                const vector<uint64_t>& same = side(v) ? sides : firstSide;
+                for (int w = 0; w < words && !found; ++w) {
+                    found = (row[w] & same[w]) != 0;
+                }
+            } else {
+                found = sameSide(v) != -1;
+            }
+            if (found) {
+                int current = conflict.load(std::memory_order_relaxed);
+                while (v < current && !conflict.compare_exchange_weak(current, v, std::memory_order_relaxed)) {
+                }
+                break;
+            }
+        }
+    });
+    int u = conflict.load();
+    if (u == numVer) {
+        return true;
+    }
+    traceOddCycle(search.distance, search.parent, u, sameSide(u), oddCycle);
+    return false;
+}
+
+/**
+ * Splits the vertices into two sides (see the overload with an odd-cycle witness).
+ *
+ * @param graph The graph.
+ * @param sides Receives one bit per vertex: bit v is set when v is on the second side.
+ * @return True if the graph is bipartite.
+ */
+bool Algorithms::bipartition(const Graph& graph, std::vector<uint64_t>& sides) {
+    std::vector<int> oddCycle;
+    return bipartition(graph, sides, oddCycle);
+}
+
 // Function to check if the graph is bipartite
 /**
- * Checks if the graph is bipartite.
+ * Checks if the graph is bipartite (see bipartition) and lists both sides.
  *
  * @param graph The graph to check.
  * @return A string indicating whether the graph is bipartite.
@@ -437,32 +2180,15 @@ void Algorithms::partitionGraph(const std::vector<int>& colors, std::vector<int>
 
 std::string Algorithms::isBipartite(const Graph& graph)  {
     int numVer = graph.getVertexNum();
-    vector<int> colors(numVer, -1); // Initialize all vertices as uncolored
-    queue<int> q;
-
-    for (int start = 0; start < numVer; ++start) {
-        if (colors[start] == -1) { // Not colored yet
-            colors[start] = 0; // Start coloring with 0
-            q.push(start);
-
-            while (!q.empty()) {
-                int v = q.front();
-                q.pop();
-                for (int u = 0; u < numVer; ++u) {
-                    if (graph.getGraph()[v][u] != 0) {
-                        if (colors[u] == -1) { // If the vertex u is not colored
-                            colors[u] = 1 - colors[v]; // Color with the opposite color
-                            q.push(u);
-                        } else if (colors[u] == colors[v]) {
-                            // If adjacent vertices have the same color, the graph is not bipartite
-                            return "0";
-                        }
-                    }
-                }
-            }
-        }
+    vector<uint64_t> sides;
+    if (!bipartition(graph, sides)) {
+        return "0";
     }
 
+    vector<int> colors(numVer);
+    for (int v = 0; v < numVer; ++v) {
+        colors[v] = (sides[v >> 6] & vertexBit(v)) != 0 ? 1 : 0;
+    }
     vector<int> partition1, partition2;
     partitionGraph(colors, partition1, partition2);
 
@@ -482,70 +2208,79 @@ std::string Algorithms::isBipartite(const Graph& graph)  {
     return result.str();
 }
 
-void Algorithms::printNegativeCycle(const std::vector<int>& parent, int start) {
+// Writes the cycle through start that the parent links close, in edge order,
+// as v0 v1 ... v0.
+static void traceNegativeCycle(const std::vector<int>& parent, int start, std::vector<int>& cycle) {
+    cycle.clear();
     int current = start;
-    std::vector<int> cycle;
     do {
         cycle.push_back(current);
         current = parent[current];
     } while (current != start);
     cycle.push_back(start);
     std::reverse(cycle.begin(), cycle.end());
+}
+
+void Algorithms::printNegativeCycle(const std::vector<int>& parent, int start, std::ostream& out) {
+    std::vector<int> cycle;
+    traceNegativeCycle(parent, start, cycle);
 
-    cout << "Negative cycle found: ";
+    out << "Negative cycle found: ";
     for (int v : cycle) {
-        cout << v << " ";
+        out << v << " ";
     }
-    cout << endl;
+    out << "\n";
+}
+
+// Runs Bellman-Ford with every vertex at distance 0, as if reached from a
+// virtual source, so a negative cycle is found wherever it is in the graph.
+// Returns a vertex on the cycle, reached from it through parent, or -1.
+static int negativeCycleVertex(const Graph& graph, std::vector<int>& parent) {
+    int numVer = graph.getVertexNum();
+    vector<int> dist(numVer, 0);
+    parent.assign(numVer, -1);
+    return relaxFromSources(graph, dist, parent);
 }
 
-// Function to detect and print negative cycles
 /**
- * Detects and prints negative cycles using the Bellman-Ford algorithm.
+ * Finds a negative cycle using the Bellman-Ford algorithm. In an undirected
+ * graph a single negative edge walked both ways does not count.
  *
  * @param graph The graph to check.
+ * @param cycle Receives the cycle as v0 v1 ... v0, following the edges; cleared if there is none.
+ * @return True if a negative cycle was found.
  */
-void Algorithms::negativeCycle(const Graph& graph) {
-    int numVer = graph.getVertexNum();
-    vector<int> dist(numVer, numeric_limits<int>::max());
-    vector<int> parent(numVer, -1);
-    dist[0] = 0; // Start from vertex 0 (or you can loop through all vertices as start points)
-
-    // Relax edges |V| - 1 times
-    for (int i = 0; i < numVer - 1; ++i) {
-        for (int u = 0; u < numVer; ++u) {
-            for (int v = 0; v < numVer; ++v) {
-                if (graph.getGraph()[u][v] != numeric_limits<int>::max() && dist[u] != numeric_limits<int>::max() && dist[u] + graph.getGraph()[u][v] < dist[v]) {
-                    dist[v] = dist[u] + graph.getGraph()[u][v];
-                    parent[v] = u;
-                }
-            }
-        }
+bool Algorithms::findNegativeCycle(const Graph& graph, std::vector<int>& cycle) {
+    cycle.clear();
+    vector<int> parent;
+    int current = negativeCycleVertex(graph, parent);
+    if (current == -1 || !isValidCycle(parent, current, graph)) {
+        return false;
     }
+    traceNegativeCycle(parent, current, cycle);
+    return true;
+}
 
-    // Check for negative weight cycles
-    for (int u = 0; u < numVer; ++u) {
-        for (int v = 0; v < numVer; ++v) {
-            if (graph.getGraph()[u][v] != numeric_limits<int>::max() && dist[u] != numeric_limits<int>::max() && dist[u] + graph.getGraph()[u][v] < dist[v]) {
-                // Negative cycle detected, reconstruct the cycle
-                vector<bool> visited(numVer, false);
-                int current = v;
-                while (!visited[current]) {
-                    visited[current] = true;
-                    current = parent[current];
-                }
-
-                if (isValidCycle(parent, current, graph)) {
-                    printNegativeCycle(parent, current);
-                } else {
-                    cout << "False positive detected, not a real negative cycle in a undirected graph." << endl;
-                }
-                return;
-            }
+// Function to detect and print negative cycles
+/**
+ * Detects and prints negative cycles using the Bellman-Ford algorithm.
+ *
+ * @param graph The graph to check.
+ * @param out The stream the result is printed to.
+ */
+void Algorithms::negativeCycle(const Graph& graph, std::ostream& out) {
+    vector<int> parent;
+    int current = negativeCycleVertex(graph, parent);
+    if (current != -1) {
+        if (isValidCycle(parent, current, graph)) {
+            printNegativeCycle(parent, current, out);
+        } else {
+            out << "False positive detected, not a real negative cycle in a undirected graph.\n";
         }
+        return;
     }
 
-    cout << "No negative cycle found." << endl;
+    out << "No negative cycle found.\n";
 }
 
 // Helper function to validate a cycle
@@ -559,19 +2294,13 @@ void Algorithms::negativeCycle(const Graph& graph) {
  */
 bool Algorithms::isValidCycle(const vector<int>& parent, int start, const Graph& graph) {
     vector<int> cycle;
-    int current = start;
-    do {
-        cycle.push_back(current);
-        current = parent[current];
-    } while (current != start);
-    cycle.push_back(start);
-    reverse(cycle.begin(), cycle.end());
+    traceNegativeCycle(parent, start, cycle);
 
     // Check for cycle length of 3 vertices (2 edges)
     if (cycle.size() == 3) {
         int u = cycle[0];
         int v = cycle[1];
-        if (!graph.getIsDirected() && graph.getGraph()[u][v] != numeric_limits<int>::max() && graph.getGraph()[v][u] != numeric_limits<int>::max()) {
+        if (!graph.getIsDirected() && graph.getWeight(u, v) != 0 && graph.getWeight(v, u) != 0) {
             return false;  // Not a valid negative cycle in a directed graph
         }
     }
@@ -1,27 +1,227 @@
 // Nadav034@gmail.com
 
+#pragma once
 #include "Graph.hpp"
+#include "DepthFirstSearch.hpp"
 #include <utility> // for std::pair
 #include <queue>
+#include <functional>
 
 
 namespace Algorithms {
-    int isConnected(Graph &graph);
+    /**
+     * Strongly connected components of a graph. Components are numbered in
+     * topological order of the condensation: every edge between two components
+     * goes from a lower id to a higher one.
+     */
+    struct StrongComponents {
+        std::vector<int> component;   // component id of each vertex
+        std::vector<int> sizes;       // number of vertices in each component
+        int count;
+        Graph condensation;           // one vertex per component, weight-1 edges between components
+    };
+
+    /**
+     * Connected components, ignoring edge directions (the weakly connected
+     * components of a directed graph). Ids follow the smallest vertex of each component.
+     */
+    struct ConnectedComponents {
+        std::vector<int> component;   // component id of each vertex
+        std::vector<int> sizes;       // number of vertices in each component
+        int count;
+    };
+
+    /**
+     * Shortest paths from one source, kept whole so that any number of targets
+     * can be read from a single search.
+     */
+    struct ShortestPathTree {
+        int source;
+        std::vector<int> distance;    // std::numeric_limits<int>::max() where unreached
+        std::vector<int> parent;      // -1 at the source and at unreached vertices
+        bool negativeCycle;           // a negative cycle is reachable; the distances are not shortest
+
+        bool reaches(int v) const;
+        std::vector<int> pathTo(int v) const;   // source ... v, or empty when v is unreached
+    };
+
+    /**
+     * Shortest paths between all pairs of vertices, as V x V row-major matrices.
+     */
+    struct AllPairsPaths {
+        int numVer;
+        std::vector<int> distance;    // std::numeric_limits<int>::max() where unreachable
+        std::vector<int> next;        // first hop from i towards j; -1 when unreachable or i == j
+        bool negativeCycle;           // some vertex lies on a negative cycle; the distances are not shortest
+
+        int getDistance(int from, int to) const;
+        std::vector<int> path(int from, int to) const;
+    };
+
+    /**
+     * Landmarks for goal-directed (ALT) search: a few vertices with their
+     * distances to and from every vertex, which bound any remaining distance
+     * from below through the triangle inequality.
+     */
+    struct Landmarks {
+        std::vector<int> vertices;
+        std::vector<std::vector<int>> from;   // from[i][v]: distance from landmark i to v
+        std::vector<std::vector<int>> to;     // to[i][v]: distance from v to landmark i
+
+        int lowerBound(int v, int target) const;
+    };
+
+    // Outcome of findShortestPath.
+    enum class PathStatus { Found, NoPath, NegativeCycle, InvalidVertex };
+
+    /**
+     * Result of findShortestPath. The vertices go to a buffer the caller owns,
+     * so repeated queries reuse its capacity instead of allocating.
+     */
+    struct PathResult {
+        PathStatus status;
+        int distance;                 // path length when status == PathStatus::Found, -1 otherwise
+    };
+
+    /**
+     * Hooks for findCycle, on top of the DepthFirstSearch ones (see DFSVisitor).
+     * cycleFound receives each cycle closed by a back edge as v0 v1 ... v0 and
+     * returns true to stop, false to look for more.
+     */
+    struct CycleVisitor : DFSVisitor {
+        bool cycleFound(const std::vector<int>&) { return true; }
+    };
+
+    /**
+     * Hook for findNegativeCycle. negativeCycleFound receives the cycle as
+     * v0 v1 ... v0, following the edges, before findNegativeCycle returns.
+     */
+    struct NegativeCycleVisitor {
+        void negativeCycleFound(const std::vector<int>&) {}
+    };
+
+    // Engine used by allPairsShortestPaths.
+    enum class AllPairsMethod { FloydWarshall, MinPlus };
+
+    // Priority queue used by dijkstraShortestPath (see PriorityQueues.hpp).
+    enum class DijkstraQueue { DAryHeap, RadixHeap };
+
+    StrongComponents stronglyConnectedComponents(const Graph& graph);
+    ConnectedComponents connectedComponents(const Graph& graph);
+    int isConnected(const Graph &graph);
     void DFSUtil(const Graph& graph, int v, std::vector<bool>& visited);
-    std::string shortestPath(Graph& graph, int start, int end);
+    PathResult findShortestPath(const Graph& graph, int start, int end, std::vector<int>& path);
+    std::string shortestPath(const Graph& graph, int start, int end);
     std::string formatPath(const std::vector<int>& path);
     std::string bellmanFordShortestPath(const Graph &g, int start, int end);
-    std::pair<int, std::vector<int>> dijkstraShortestPath(const Graph &graph, int start, int end);
+    std::pair<int, std::vector<int>> dijkstraShortestPath(const Graph &graph, int start, int end, DijkstraQueue queue = DijkstraQueue::DAryHeap);
+    ShortestPathTree shortestPathTree(const Graph& graph, int source, const std::vector<int>& targets = std::vector<int>());
+    std::vector<ShortestPathTree> shortestPathTrees(const Graph& graph, const std::vector<int>& sources, const std::vector<int>& targets = std::vector<int>());
+    AllPairsPaths allPairsShortestPaths(const Graph& graph, AllPairsMethod method = AllPairsMethod::FloydWarshall);
+    std::pair<int, std::vector<int>> deltaSteppingShortestPath(const Graph &graph, int start, int end, int delta = 0);
+    std::pair<int, std::vector<int>> bidirectionalShortestPath(const Graph &graph, int start, int end);
+    Landmarks selectLandmarks(const Graph& graph, int count);
+    std::pair<int, std::vector<int>> aStarShortestPath(const Graph &graph, int start, int end, const std::function<int(int)>& lowerBound);
+    std::pair<int, std::vector<int>> aStarShortestPath(const Graph &graph, int start, int end, const Landmarks& landmarks);
     std::pair<int, std::vector<int>> bfsShortestPath(const Graph &graph, int start, int end);
-    std::string isContainsCycle(const Graph& graph);
-    void printCycle(const std::vector<int> &parent, int start, int end);
+    bool findCycle(const Graph& graph, std::vector<int>& cycle);
+    template <typename Visitor>
+    bool findCycle(const Graph& graph, std::vector<int>& cycle, Visitor& visitor);
+    std::string isContainsCycle(const Graph& graph, std::ostream& out);
+    void traceCycle(const std::vector<int>& parent, int start, int end, std::vector<int>& cycle);
+    void printCycle(const std::vector<int> &parent, int start, int end, std::ostream& out);
+    // Deprecated single-root cycle checks, kept for old callers. Each call sets up
+    // a fresh search in O(V), so looping them over every vertex costs O(V^2);
+    // use findCycle, or DepthFirstSearch::runAll with a CycleDetector, instead.
+    __attribute__((deprecated("use findCycle or DepthFirstSearch::runAll")))
     bool DFSUtilUndirected(int v, int parent, const Graph &graph, std::vector<bool> &visited, std::vector<int> &parentVec);
-    bool DFSUtilDirected(int v, const Graph &graph, std::vector<bool> &visited, std::vector<bool> &recStack,std::vector<int> &parentVec);
+    __attribute__((deprecated("use findCycle or DepthFirstSearch::runAll")))
+    bool DFSUtilDirected(int v, const Graph &graph, std::vector<bool> &visited, std::vector<int> &parentVec);
+    bool bipartition(const Graph& graph, std::vector<uint64_t>& sides);
+    bool bipartition(const Graph& graph, std::vector<uint64_t>& sides, std::vector<int>& oddCycle);
     std::string isBipartite(const Graph& graph);
     void partitionGraph(const std::vector<int>& colors, std::vector<int>& partition1, std::vector<int>& partition2);
-    void relaxEdges(const Graph &g, std::vector<int> &dist, std::vector<int> &parent);
-    void printNegativeCycle(const std::vector<int> &parent, int start);
+    bool relaxEdges(const Graph &g, std::vector<int> &dist, std::vector<int> &parent);
+    void printNegativeCycle(const std::vector<int> &parent, int start, std::ostream& out);
     bool isValidCycle(const vector<int>& parent, int start, const Graph& graph);
-    void negativeCycle(const Graph& graph);
+    bool findNegativeCycle(const Graph& graph, std::vector<int>& cycle);
+    template <typename Visitor>
+    bool findNegativeCycle(const Graph& graph, std::vector<int>& cycle, Visitor& visitor);
+    void negativeCycle(const Graph& graph, std::ostream& out);
+
+    /**
+     * DepthFirstSearch visitor that reports the cycle closed by each back edge
+     * and forwards every hook to the caller's visitor, so hooks the caller does
+     * not define cost nothing.
+     */
+    template <typename Visitor>
+    class CycleDetector : public DFSVisitor {
+    public:
+        CycleDetector(const DepthFirstSearch& search, bool directed, std::vector<int>& cycle, Visitor& visitor)
+            : search(search), directed(directed), found(false), cycle(cycle), visitor(visitor) {}
+
+        bool foundCycle() const { return found; }
+
+        bool discover(int v) { return visitor.discover(v); }
+        bool examineEdge(int u, int v, int weight) { return visitor.examineEdge(u, v, weight); }
+        bool treeEdge(int u, int v, int weight) { return visitor.treeEdge(u, v, weight); }
+        bool otherEdge(int u, int v, int weight) { return visitor.otherEdge(u, v, weight); }
+        bool finish(int v) { return visitor.finish(v); }
+
+        bool backEdge(int u, int v, int weight) {
+            if (visitor.backEdge(u, v, weight)) {
+                return true;
+            }
+            // In an undirected graph the edge back to the DFS parent is the tree edge itself
+            if (!directed && v == search.getParents()[u]) {
+                return false;
+            }
+            found = true;
+            traceCycle(search.getParents(), u, v, cycle);
+            return visitor.cycleFound(cycle);
+        }
+
+    private:
+        const DepthFirstSearch& search;
+        bool directed;
+        bool found;
+        std::vector<int>& cycle;
+        Visitor& visitor;
+    };
+
+    /**
+     * Searches the whole graph for cycles with one iterative DFS, reporting
+     * each one to visitor (see CycleVisitor).
+     *
+     * @param graph The graph.
+     * @param cycle Receives the last cycle found; cleared if there is none.
+     * @param visitor Receives the DFS hooks and cycleFound.
+     * @return True if a cycle was found.
+     */
+    template <typename Visitor>
+    bool findCycle(const Graph& graph, std::vector<int>& cycle, Visitor& visitor) {
+        cycle.clear();
+        DepthFirstSearch search(graph);
+        CycleDetector<Visitor> detector(search, graph.isGraphDirected(), cycle, visitor);
+        search.runAll(detector);
+        return detector.foundCycle();
+    }
 
+    /**
+     * Finds a negative cycle as findNegativeCycle(graph, cycle) does and reports
+     * it to visitor (see NegativeCycleVisitor).
+     *
+     * @param graph The graph to check.
+     * @param cycle Receives the cycle; cleared if there is none.
+     * @param visitor Receives negativeCycleFound when a cycle is found.
+     * @return True if a negative cycle was found.
+     */
+    template <typename Visitor>
+    bool findNegativeCycle(const Graph& graph, std::vector<int>& cycle, Visitor& visitor) {
+        if (!findNegativeCycle(graph, cycle)) {
+            return false;
+        }
+        visitor.negativeCycleFound(cycle);
+        return true;
+    }
 }
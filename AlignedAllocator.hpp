@@ -0,0 +1,51 @@
+// Nadav034@gmail.com
+
+#pragma once
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+/**
+ * Minimal allocator returning memory aligned to Alignment bytes, so that each
+ * matrix row can start on a cache-line boundary.
+ */
+template <typename T, std::size_t Alignment = 64>
+class AlignedAllocator {
+public:
+    typedef T value_type;
+
+    template <typename U>
+    struct rebind {
+        typedef AlignedAllocator<U, Alignment> other;
+    };
+
+    AlignedAllocator() {}
+
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(std::size_t n) {
+        void* p = nullptr;
+        if (n == 0) {
+            n = 1;
+        }
+        if (posix_memalign(&p, Alignment, n * sizeof(T)) != 0) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(p);
+    }
+
+    void deallocate(T* p, std::size_t) {
+        std::free(p);
+    }
+};
+
+template <typename T, typename U, std::size_t Alignment>
+bool operator==(const AlignedAllocator<T, Alignment>&, const AlignedAllocator<U, Alignment>&) {
+    return true;
+}
+
+template <typename T, typename U, std::size_t Alignment>
+bool operator!=(const AlignedAllocator<T, Alignment>&, const AlignedAllocator<U, Alignment>&) {
+    return false;
+}
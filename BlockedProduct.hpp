@@ -0,0 +1,47 @@
+// Nadav034@gmail.com
+
+#pragma once
+#include <algorithm>
+
+// Tile sizes of the cache-blocked matrix products: 32 rows x 256 columns of the
+// result, streaming 128 rows of the right operand at a time so its tile stays in L2.
+const int productRowBlock = 32;
+const int productColBlock = 256;
+const int productDepthBlock = 128;
+
+/**
+ * Loop nest shared by the matrix products over a semiring: the dense (+, x)
+ * product of Graph::operator* and the (min, +) product of the all-pairs
+ * shortest paths. Result rows [rowBegin, rowEnd) are walked in tiles; within a
+ * tile the innermost call runs along a row of the right operand, so every
+ * access is sequential. The semiring supplies the arithmetic:
+ *
+ *     void beginTile(int row, int rows, int col, int width);   // before a result tile
+ *     void accumulate(int i, int k, int col, int width);       // c[i][col..] (+)= a[i][k] (x) b[k][col..]
+ *     void endTile(int row, int rows, int col, int width);     // after a result tile
+ *
+ * @param n The inner dimension: columns of the left operand, rows of the right one.
+ * @param cols The number of result columns to compute, starting at 0.
+ * @param rowBegin The first result row to compute.
+ * @param rowEnd One past the last result row to compute.
+ * @param semiring The (+, x) operations and their accumulator.
+ */
+template <typename Semiring>
+void blockedProduct(int n, int cols, int rowBegin, int rowEnd, Semiring& semiring) {
+    for (int ii = rowBegin; ii < rowEnd; ii += productRowBlock) {
+        int rows = std::min(productRowBlock, rowEnd - ii);
+        for (int jj = 0; jj < cols; jj += productColBlock) {
+            int width = std::min(productColBlock, cols - jj);
+            semiring.beginTile(ii, rows, jj, width);
+            for (int kk = 0; kk < n; kk += productDepthBlock) {
+                int depthEnd = std::min(n, kk + productDepthBlock);
+                for (int i = ii; i < ii + rows; ++i) {
+                    for (int k = kk; k < depthEnd; ++k) {
+                        semiring.accumulate(i, k, jj, width);
+                    }
+                }
+            }
+            semiring.endTile(ii, rows, jj, width);
+        }
+    }
+}
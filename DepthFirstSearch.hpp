@@ -0,0 +1,163 @@
+// Nadav034@gmail.com
+
+#pragma once
+#include "Graph.hpp"
+#include <vector>
+#include <algorithm>
+
+/**
+ * Hooks called by DepthFirstSearch. Each returns true to stop the search early.
+ * Visitors derive from this struct and hide the hooks they need; the search is
+ * a template over the visitor, so the calls are resolved and inlined at compile time.
+ */
+struct DFSVisitor {
+    // v is reached for the first time.
+    bool discover(int) { return false; }
+    // u -> v is looked at; called before the hook for its kind of edge.
+    bool examineEdge(int, int, int) { return false; }
+    // v is reached from u; called before discover(v).
+    bool treeEdge(int, int, int) { return false; }
+    // u -> v where v is still on the current DFS path.
+    bool backEdge(int, int, int) { return false; }
+    // u -> v where v was already finished (forward or cross edge).
+    bool otherEdge(int, int, int) { return false; }
+    // Every edge leaving v has been explored.
+    bool finish(int) { return false; }
+};
+
+/**
+ * Iterative depth-first search over a Graph. The recursion is replaced by an
+ * explicit stack of frames, each holding a vertex and its resumable nextEdge
+ * cursor, so a path of any length cannot overflow the call stack. All memory
+ * (state, parent and one stack frame per vertex) is allocated up front, about
+ * 13 bytes per vertex, and the stack never grows past it.
+ *
+ * One search object can run from several roots; vertices reached by an earlier
+ * run are skipped by later ones, as in a DFS forest.
+ */
+class DepthFirstSearch {
+public:
+    enum VertexState : unsigned char {
+        Unvisited,
+        Active,    // on the current DFS path
+        Finished
+    };
+
+    /**
+     * @param graph The graph to search; it must outlive the search.
+     */
+    explicit DepthFirstSearch(const Graph& graph)
+        : graph(graph), states(graph.getVertexNum(), Unvisited), parents(graph.getVertexNum(), -1) {
+        stack.reserve(graph.getVertexNum());
+    }
+
+    /**
+     * Searches from root, skipping vertices an earlier run reached.
+     *
+     * @param root The start vertex.
+     * @param visitor Receives the DFSVisitor hooks.
+     * @return True if a hook stopped the search. The search must then be reset() before it runs again.
+     */
+    template <typename Visitor>
+    bool run(int root, Visitor& visitor) {
+        if (states[root] != Unvisited) {
+            return false;
+        }
+        states[root] = Active;
+        parents[root] = -1;
+        if (visitor.discover(root)) {
+            return true;
+        }
+        stack.push_back(Frame{root, graph.edgeBegin(root)});
+        while (!stack.empty()) {
+            Frame& top = stack.back();
+            int v = top.vertex, u, weight;
+            if (graph.nextEdge(v, top.pos, u, weight)) {
+                if (visitor.examineEdge(v, u, weight)) {
+                    return true;
+                }
+                if (states[u] == Unvisited) {
+                    states[u] = Active;
+                    parents[u] = v;
+                    if (visitor.treeEdge(v, u, weight) || visitor.discover(u)) {
+                        return true;
+                    }
+                    stack.push_back(Frame{u, graph.edgeBegin(u)});
+                } else if (states[u] == Active) {
+                    if (visitor.backEdge(v, u, weight)) {
+                        return true;
+                    }
+                } else if (visitor.otherEdge(v, u, weight)) {
+                    return true;
+                }
+            } else {
+                states[v] = Finished;
+                stack.pop_back();
+                if (visitor.finish(v)) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Runs from every unvisited vertex in increasing order, covering the whole graph.
+     *
+     * @param visitor Receives the DFSVisitor hooks.
+     * @return True if a hook stopped the search.
+     */
+    template <typename Visitor>
+    bool runAll(Visitor& visitor) {
+        for (int v = 0; v < static_cast<int>(states.size()); ++v) {
+            if (states[v] == Unvisited && run(v, visitor)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Forgets every earlier run.
+     */
+    void reset() {
+        std::fill(states.begin(), states.end(), Unvisited);
+        std::fill(parents.begin(), parents.end(), -1);
+        stack.clear();
+    }
+
+    /**
+     * Marks v as already finished, so no run enters it.
+     *
+     * @param v The vertex to exclude.
+     */
+    void markVisited(int v) {
+        states[v] = Finished;
+    }
+
+    VertexState getState(int v) const {
+        return static_cast<VertexState>(states[v]);
+    }
+
+    bool isVisited(int v) const {
+        return states[v] != Unvisited;
+    }
+
+    /**
+     * @return The DFS tree parent of every vertex; -1 for roots and unvisited vertices.
+     */
+    const std::vector<int>& getParents() const {
+        return parents;
+    }
+
+private:
+    struct Frame {
+        int vertex;
+        int pos;
+    };
+
+    const Graph& graph;
+    std::vector<unsigned char> states;
+    std::vector<int> parents;
+    std::vector<Frame> stack;
+};
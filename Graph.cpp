@@ -1,32 +1,432 @@
 //  Nadav034@gmail.com
 
 #include "Graph.hpp"
+#include "ThreadPool.hpp"
+#include "BlockedProduct.hpp"
 #include <iostream>
 #include <vector>
 #include <stdexcept>
+#include <algorithm>
+#include <limits>
+#include <atomic>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 using namespace std;
 
+static int addWeight(int weight, int delta) {
+    return weight + delta;
+}
+
+static int scaleWeight(int weight, int factor) {
+    return weight * factor;
+}
+
+static int divideWeight(int weight, int divisor) {
+    return weight / divisor;
+}
+
+// Row stride in ints: rows are padded to whole 64-byte cache lines.
+static int paddedStride(int vertices) {
+    return (vertices + 15) & ~15;
+}
+
+// Matrix product kernels. Each adds factor * row[0..count) into acc[0..count);
+// count is always a multiple of 16 because strides are padded.
+
+static void addScaledRow(int* acc, const int* row, int factor, int count) {
+    for (int j = 0; j < count; ++j) {
+        acc[j] += factor * row[j];
+    }
+}
+
+static void addScaledRow(long long* acc, const int* row, int factor, int count) {
+    for (int j = 0; j < count; ++j) {
+        acc[j] += static_cast<long long>(factor) * row[j];
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+static void addScaledRowAvx2(int* acc, const int* row, int factor, int count) {
+    __m256i scale = _mm256_set1_epi32(factor);
+    for (int j = 0; j < count; j += 8) {
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + j));
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + j));
+        c = _mm256_add_epi32(c, _mm256_mullo_epi32(scale, b));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + j), c);
+    }
+}
+
+__attribute__((target("avx2")))
+static void addScaledRowAvx2(long long* acc, const int* row, int factor, int count) {
+    // _mm256_mul_epi32 multiplies the low signed 32 bits of each 64-bit lane
+    __m256i scale = _mm256_set1_epi64x(factor);
+    for (int j = 0; j < count; j += 4) {
+        __m256i b = _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + j)));
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + j));
+        c = _mm256_add_epi64(c, _mm256_mul_epi32(scale, b));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + j), c);
+    }
+}
+#endif
+
+// Picks the AVX2 kernels once, when the CPU running the program supports them.
+static bool cpuHasAvx2() {
+#if defined(__x86_64__) || defined(__i386__)
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+/**
+ * The (+, x) semiring for blockedProduct. Each result tile is summed in an Acc
+ * buffer, zero cells of a are skipped, and the finished tile is narrowed into c.
+ */
+template <typename Acc>
+class SumProductTiles {
+public:
+    SumProductTiles(const int* a, const int* b, int* c, int stride, void (*kernel)(Acc*, const int*, int, int), bool checkRange)
+        : a(a), b(b), c(c), stride(stride), kernel(kernel), checkRange(checkRange), tileRow(0),
+          acc(static_cast<size_t>(productRowBlock) * productColBlock) {}
+
+    void beginTile(int row, int, int, int) {
+        tileRow = row;
+        std::fill(acc.begin(), acc.end(), 0);
+    }
+
+    void accumulate(int i, int k, int col, int width) {
+        int factor = a[static_cast<size_t>(i) * stride + k];
+        if (factor != 0) {
+            kernel(&acc[static_cast<size_t>(i - tileRow) * productColBlock], b + static_cast<size_t>(k) * stride + col, factor, width);
+        }
+    }
+
+    void endTile(int row, int rows, int col, int width) {
+        for (int i = 0; i < rows; ++i) {
+            int* cRow = c + static_cast<size_t>(row + i) * stride + col;
+            const Acc* accRow = &acc[static_cast<size_t>(i) * productColBlock];
+            for (int j = 0; j < width; ++j) {
+                if (checkRange && (accRow[j] > std::numeric_limits<int>::max() || accRow[j] < std::numeric_limits<int>::min())) {
+                    throw std::overflow_error("Graph multiplication overflows int.");
+                }
+                cRow[j] = static_cast<int>(accRow[j]);
+            }
+        }
+    }
+
+private:
+    const int* a;
+    const int* b;
+    int* c;
+    int stride;
+    void (*kernel)(Acc*, const int*, int, int);
+    bool checkRange;
+    int tileRow;
+    vector<Acc> acc;
+};
+
+/**
+ * Cache-blocked dense product c = a * b of n x n matrices sharing a padded stride,
+ * tiled as described in BlockedProduct.hpp.
+ *
+ * @param a The left matrix.
+ * @param b The right matrix.
+ * @param c The zeroed result matrix.
+ * @param n The number of vertices.
+ * @param stride The padded row stride of all three matrices.
+ * @param rowBegin The first result row to compute.
+ * @param rowEnd One past the last result row to compute.
+ * @param kernel Adds a scaled row of b into an accumulator row.
+ * @param checkRange True to throw when a result cell does not fit in an int.
+ * @throws std::overflow_error if checkRange is set and a cell overflows.
+ */
+template <typename Acc>
+static void blockedMultiply(const int* a, const int* b, int* c, int n, int stride, int rowBegin, int rowEnd,
+                            void (*kernel)(Acc*, const int*, int, int), bool checkRange) {
+    SumProductTiles<Acc> tiles(a, b, c, stride, kernel, checkRange);
+    blockedProduct(n, stride, rowBegin, rowEnd, tiles);
+}
+
+// Stores a 64-bit accumulated product cell, checking its range when asked.
+static int narrowProduct(long long value, bool checkRange) {
+    if (checkRange && (value > std::numeric_limits<int>::max() || value < std::numeric_limits<int>::min())) {
+        throw std::overflow_error("Graph multiplication overflows int.");
+    }
+    return static_cast<int>(value);
+}
+
 // Constructors
 
+/**
+ * Empty data: no vertices, an empty matrix and no cached properties.
+ */
+GraphData::GraphData()
+    : numVer(0), storage(Storage::Dense), propertiesValid(false), isDirected(false), isWeighted(false),
+      minWeight(0), maxWeight(0), nonZeroCount(0), stride(0), bitWords(0), matrixViewValid(false),
+      incomingValid(false), componentCount(0), componentsValid(false) {}
+
+/**
+ * Copies graph data. The cached matrix view and incoming edges are never copied;
+ * the connectivity index is copied with the storage, as it only takes O(V).
+ *
+ * @param other The data to copy.
+ * @param copyStorage False to copy only the vertex count, backend and properties, leaving the arrays empty.
+ */
+GraphData::GraphData(const GraphData& other, bool copyStorage)
+    : numVer(other.numVer), storage(other.storage), propertiesValid(other.propertiesValid.load()),
+      isDirected(other.isDirected), isWeighted(other.isWeighted), minWeight(other.minWeight),
+      maxWeight(other.maxWeight), nonZeroCount(other.nonZeroCount), degrees(other.degrees),
+      stride(0), bitWords(0), matrixViewValid(false), incomingValid(false), componentCount(0),
+      componentsValid(false) {
+    if (copyStorage) {
+        stride = other.stride;
+        cells = other.cells;
+        rowOffsets = other.rowOffsets;
+        colTargets = other.colTargets;
+        edgeWeights = other.edgeWeights;
+        bitWords = other.bitWords;
+        bitRows = other.bitRows;
+        if (other.componentsValid) {
+            componentParent = other.componentParent;
+            componentCount = other.componentCount;
+            componentsValid = true;
+        }
+    }
+}
+
 /**
  * Constructs a Graph with a specified adjacency matrix, direction, and weight status.
+ * Direction and weights are derived from the matrix, as loadGraph does, so flags
+ * that contradict it cannot change any result.
  *
  * @param newGraph The adjacency matrix.
- * @param directed True if the graph is directed.
- * @param weighted True if the graph has weighted edges.
+ * @param directed True if the graph is directed; recomputed from the matrix.
+ * @param weighted True if the graph has weighted edges; recomputed from the matrix.
  * @param vertex The number of vertices in the graph.
  */
-Graph::Graph(std::vector<std::vector<int>> newGraph, bool directed, bool weighted, int vertex) {
-    this->graph = newGraph;
-    this->isDirected = directed;
-    this->isWeighted = weighted;
-    this->numVer = vertex;
+Graph::Graph(std::vector<std::vector<int>> newGraph, bool /*directed*/, bool /*weighted*/, int vertex)
+    : data(std::make_shared<GraphData>()) {
+    resetDense(vertex);
+    for (int i = 0; i < vertex; ++i) {
+        std::copy(newGraph[i].begin(), newGraph[i].begin() + vertex, data->cells.begin() + static_cast<size_t>(i) * data->stride);
+    }
+    computeProperties();
 }
 
 /**
  * Default constructor for an empty graph.
  */
-Graph::Graph() : numVer(0), isDirected(false), isWeighted(false) {}
+Graph::Graph() : data(std::make_shared<GraphData>()) {}
+
+/**
+ * Copy constructor. The copy shares the other graph's data until either changes, so it costs O(1).
+ *
+ * @param other The graph to copy.
+ */
+Graph::Graph(const Graph& other) : data(other.data) {}
+
+/**
+ * Data of an empty graph, shared by every moved-from graph. Like any shared
+ * data it is copied before a change, so it always stays empty.
+ *
+ * @return The shared empty data.
+ */
+static const std::shared_ptr<GraphData>& emptyData() {
+    static const std::shared_ptr<GraphData> empty = std::make_shared<GraphData>();
+    return empty;
+}
+
+/**
+ * Move constructor. The moved-from graph is left empty, sharing the empty data.
+ *
+ * @param other The graph to move from.
+ */
+Graph::Graph(Graph&& other) noexcept : data(std::move(other.data)) {
+    other.data = emptyData();
+}
+
+/**
+ * Copy assignment. Shares the other graph's data until either changes.
+ *
+ * @param other The graph to copy.
+ * @return This graph.
+ */
+Graph& Graph::operator=(const Graph& other) {
+    data = other.data;
+    return *this;
+}
+
+/**
+ * Move assignment. The moved-from graph keeps this graph's previous data.
+ *
+ * @param other The graph to move from.
+ * @return This graph.
+ */
+Graph& Graph::operator=(Graph&& other) noexcept {
+    data.swap(other.data);
+    return *this;
+}
+
+/**
+ * Gives this graph its own data before it changes, if other graphs share it.
+ * A graph that is the only owner keeps its data untouched.
+ *
+ * @param copyStorage False when the caller is about to replace the backing arrays,
+ *                    so only the vertex count, backend and properties are copied.
+ */
+void Graph::detach(bool copyStorage) {
+    if (data.use_count() > 1) {
+        data = std::make_shared<GraphData>(*data, copyStorage);
+    }
+}
+
+/**
+ * Computes direction, weight range, edge count and out-degrees in one pass.
+ * Sparse graphs look up the reverse of each edge with a binary search.
+ */
+void Graph::computeProperties() const {
+    bool asymmetric = false;
+    int low = 0, high = 0, count = 0;
+    data->degrees.assign(data->numVer, 0);
+    for (int i = 0; i < data->numVer; ++i) {
+        int pos = edgeBegin(i), j, weight;
+        while (nextEdge(i, pos, j, weight)) {
+            if (count == 0 || weight < low) {
+                low = weight;
+            }
+            if (count == 0 || weight > high) {
+                high = weight;
+            }
+            ++count;
+            ++data->degrees[i];
+            if (!asymmetric && getWeight(j, i) != weight) {
+                asymmetric = true;
+            }
+        }
+    }
+    data->isDirected = asymmetric;
+    data->isWeighted = high > 1 || low < 0;
+    data->minWeight = low;
+    data->maxWeight = high;
+    data->nonZeroCount = count;
+    data->propertiesValid = true;
+}
+
+/**
+ * Computes the cached properties if the edges changed since the last query.
+ */
+void Graph::ensureProperties() const {
+    if (!data->propertiesValid) {
+        lock_guard<std::mutex> lock(data->cacheMutex);
+        if (!data->propertiesValid) {
+            computeProperties();
+        }
+    }
+}
+
+/**
+ * Marks the cached properties stale after the edges changed.
+ */
+void Graph::invalidateProperties() {
+    data->propertiesValid = false;
+}
+
+/**
+ * Updates the cached properties after every edge weight moved by delta.
+ * If some weight could have reached zero the edge set changed and the
+ * properties are recomputed on the next query instead.
+ *
+ * @param delta The amount added to every edge weight.
+ */
+void Graph::shiftProperties(int delta) {
+    if (!data->propertiesValid || data->nonZeroCount == 0) {
+        return;
+    }
+    if (data->minWeight <= -delta && -delta <= data->maxWeight) {
+        data->propertiesValid = false;
+        return;
+    }
+    data->minWeight += delta;
+    data->maxWeight += delta;
+    data->isWeighted = data->maxWeight > 1 || data->minWeight < 0;
+}
+
+/**
+ * Derives this graph's properties from source after every weight was multiplied by factor.
+ * Non-zero factors keep the edge set, so only the weight range changes.
+ *
+ * @param source The graph before scaling.
+ * @param factor The multiplier.
+ */
+void Graph::scaleProperties(const Graph& source, int factor) {
+    if (!source.data->propertiesValid || factor == 0) {
+        data->propertiesValid = false;
+        return;
+    }
+    // source may be this graph, so read both bounds before writing either
+    int newMin = factor > 0 ? source.data->minWeight * factor : source.data->maxWeight * factor;
+    int newMax = factor > 0 ? source.data->maxWeight * factor : source.data->minWeight * factor;
+    data->propertiesValid = true;
+    data->isDirected = source.data->isDirected;
+    data->nonZeroCount = source.data->nonZeroCount;
+    data->degrees = source.data->degrees;
+    data->minWeight = newMin;
+    data->maxWeight = newMax;
+    data->isWeighted = data->nonZeroCount > 0 && (data->maxWeight > 1 || data->minWeight < 0);
+}
+
+/**
+ * Allocates a zeroed vertices x vertices matrix as one padded buffer.
+ *
+ * @param vertices The number of vertices.
+ */
+void Graph::resetDense(int vertices) {
+    detach(false);
+    data->numVer = vertices;
+    data->stride = paddedStride(vertices);
+    data->cells.assign(static_cast<size_t>(vertices) * data->stride, 0);
+    invalidateView();
+}
+
+/**
+ * Drops the cached getGraph() view, incoming edges and connectivity index after
+ * the graph changed.
+ */
+void Graph::invalidateView() {
+    vector<vector<int>>().swap(data->matrixView);
+    data->matrixViewValid = false;
+    vector<int>().swap(data->inOffsets);
+    vector<int>().swap(data->inSources);
+    vector<int>().swap(data->inWeights);
+    data->incomingValid = false;
+    vector<int>().swap(data->componentParent);
+    data->componentsValid = false;
+}
+
+/**
+ * Creates an edgeless graph with this graph's size.
+ *
+ * @param resultStorage The backing store of the new graph.
+ * @return A zeroed matrix or bit matrix, or CSR arrays with empty rows.
+ */
+Graph Graph::emptyResult(Storage resultStorage) const {
+    Graph result;
+    result.data->storage = resultStorage;
+    if (resultStorage == Storage::Dense) {
+        result.resetDense(data->numVer);
+    } else if (resultStorage == Storage::Sparse) {
+        result.data->numVer = data->numVer;
+        result.data->rowOffsets.assign(data->numVer + 1, 0);
+    } else {
+        result.data->numVer = data->numVer;
+        result.data->bitWords = (data->numVer + 63) / 64;
+        result.data->bitRows.assign(static_cast<size_t>(data->numVer) * result.data->bitWords, 0);
+    }
+    return result;
+}
 
 /**
  * Loads a new adjacency matrix into the graph.
@@ -36,10 +436,10 @@ Graph::Graph() : numVer(0), isDirected(false), isWeighted(false) {}
  */
 void Graph::loadGraph(const vector<vector<int>>& newGraph) {
     if (newGraph.empty()) {
-        graph.clear();
-        numVer = 0;
-        isDirected = false;
-        isWeighted = false;
+        releaseStorage();
+        data->storage = Storage::Dense;
+        resetDense(0);
+        computeProperties();
         return;
     }
 
@@ -50,74 +450,234 @@ void Graph::loadGraph(const vector<vector<int>>& newGraph) {
         }
     }
 
-    graph = newGraph;
-    numVer = static_cast<int>(rows);
-    isDirected = isGraphDirected();
-    isWeighted = isGraphWeighted();
+    releaseStorage();
+    data->storage = Storage::Dense;
+    resetDense(static_cast<int>(rows));
+    for (std::size_t i = 0; i < rows; ++i) {
+        std::copy(newGraph[i].begin(), newGraph[i].end(), data->cells.begin() + i * data->stride);
+    }
+    computeProperties();
 }
 
 /**
- * Prints the graph's adjacency matrix.
+ * Loads a graph given in compressed sparse row form. Row v holds the edges
+ * targets[offsets[v]] .. targets[offsets[v + 1] - 1] with the matching weights.
+ * Zero weights are dropped, since zero means "no edge" in the matrix form too.
+ *
+ * @param vertices The number of vertices.
+ * @param offsets Row start offsets, vertices + 1 entries beginning with 0.
+ * @param targets Edge targets, strictly increasing within each row.
+ * @param weights Edge weights, one per target.
+ * @throws std::invalid_argument if the arrays do not describe a valid CSR graph.
  */
-void Graph::printGraph() {
-    for (int i = 0; i < numVer; ++i) {
-        for (int j = 0; j < numVer; ++j) {
-            cout << this->graph[i][j] << " ";
+void Graph::loadSparseGraph(int vertices, const vector<int>& offsets, const vector<int>& targets, const vector<int>& weights) {
+    if (vertices < 0 || offsets.size() != static_cast<size_t>(vertices) + 1 || offsets[0] != 0) {
+        throw std::invalid_argument("Invalid graph: offsets must hold vertices + 1 entries starting at 0.");
+    }
+    // Check every offset before reading any row, so a bad one cannot index past targets
+    for (int v = 0; v < vertices; ++v) {
+        if (offsets[v + 1] < offsets[v] || static_cast<size_t>(offsets[v + 1]) > targets.size()) {
+            throw std::invalid_argument("Invalid graph: offsets must be non-decreasing and within targets.");
         }
-        cout << endl;
     }
+    if (targets.size() != weights.size() || static_cast<size_t>(offsets[vertices]) != targets.size()) {
+        throw std::invalid_argument("Invalid graph: offsets, targets and weights sizes do not match.");
+    }
+    vector<int> newOffsets(1, 0);
+    vector<int> newTargets;
+    vector<int> newWeights;
+    newTargets.reserve(targets.size());
+    newWeights.reserve(weights.size());
+    for (int v = 0; v < vertices; ++v) {
+        for (int pos = offsets[v]; pos < offsets[v + 1]; ++pos) {
+            if (targets[pos] < 0 || targets[pos] >= vertices || (pos > offsets[v] && targets[pos] <= targets[pos - 1])) {
+                throw std::invalid_argument("Invalid graph: row targets must be in range and strictly increasing.");
+            }
+            if (weights[pos] != 0) {
+                newTargets.push_back(targets[pos]);
+                newWeights.push_back(weights[pos]);
+            }
+        }
+        newOffsets.push_back(static_cast<int>(newTargets.size()));
+    }
+
+    releaseStorage();
+    data->rowOffsets.swap(newOffsets);
+    data->colTargets.swap(newTargets);
+    data->edgeWeights.swap(newWeights);
+    data->storage = Storage::Sparse;
+    data->numVer = vertices;
+    computeProperties();
 }
 
 /**
- * Checks if the graph is directed.
- *
- * @return True if the graph is directed.
+ * Converts the backing store to compressed sparse rows. The previous store is released.
  */
-bool Graph::isGraphDirected() {
-    for (int i = 0; i < this->getVertexNum(); ++i) {
-        for (int j = 0; j < this->getVertexNum(); ++j) {
-            if (this->getGraph()[i][j] != this->getGraph()[j][i]) {
-                this->isDirected = true;
-                return true;
-            }
+void Graph::toSparse() {
+    if (data->storage == Storage::Sparse) {
+        return;
+    }
+    vector<int> newOffsets(1, 0);
+    vector<int> newTargets;
+    vector<int> newWeights;
+    for (int i = 0; i < data->numVer; ++i) {
+        int pos = edgeBegin(i), j, weight;
+        while (nextEdge(i, pos, j, weight)) {
+            newTargets.push_back(j);
+            newWeights.push_back(weight);
         }
+        newOffsets.push_back(static_cast<int>(newTargets.size()));
     }
-    this->isDirected = false;
-    return false;
+    releaseStorage();
+    data->rowOffsets.swap(newOffsets);
+    data->colTargets.swap(newTargets);
+    data->edgeWeights.swap(newWeights);
+    data->storage = Storage::Sparse;
 }
 
 /**
- * Checks if the graph has weighted edges.
+ * Converts the backing store to a V x V adjacency matrix. The previous store is released.
+ */
+void Graph::toDense() {
+    if (data->storage == Storage::Dense) {
+        return;
+    }
+    int newStride = paddedStride(data->numVer);
+    vector<int, AlignedAllocator<int>> newCells(static_cast<size_t>(data->numVer) * newStride, 0);
+    for (int i = 0; i < data->numVer; ++i) {
+        int pos = edgeBegin(i), j, weight;
+        while (nextEdge(i, pos, j, weight)) {
+            newCells[static_cast<size_t>(i) * newStride + j] = weight;
+        }
+    }
+    releaseStorage();
+    data->stride = newStride;
+    data->cells.swap(newCells);
+    data->storage = Storage::Dense;
+}
+
+/**
+ * Converts the backing store to one bit per matrix cell, 32 times smaller than
+ * the int matrix. Only unweighted graphs (all weights 0 or 1) can be packed.
  *
- * @return True if the graph has weighted edges.
+ * @throws std::invalid_argument if the graph has weights other than 0 and 1.
  */
-bool Graph::isGraphWeighted() {
-    for (int i = 0; i < this->getVertexNum(); ++i) {
-        for (int j = 0; j < this->getVertexNum(); ++j) {
-            if ((this->getGraph()[i][j] > 1) || (this->getGraph()[i][j] < 0)) {
-                this->isWeighted = true;
-                return true;
-            }
+void Graph::toBitPacked() {
+    if (data->storage == Storage::BitPacked) {
+        return;
+    }
+    if (isGraphWeighted()) {
+        throw std::invalid_argument("Only unweighted graphs can be bit-packed.");
+    }
+    int newWords = (data->numVer + 63) / 64;
+    vector<uint64_t> newRows(static_cast<size_t>(data->numVer) * newWords, 0);
+    for (int i = 0; i < data->numVer; ++i) {
+        int pos = edgeBegin(i), j, weight;
+        while (nextEdge(i, pos, j, weight)) {
+            newRows[static_cast<size_t>(i) * newWords + (j >> 6)] |= uint64_t(1) << (j & 63);
         }
     }
-    this->isWeighted = false;
-    return false;
+    releaseStorage();
+    data->bitWords = newWords;
+    data->bitRows.swap(newRows);
+    data->storage = Storage::BitPacked;
 }
 
 /**
- * Checks if the graph has negative weights.
+ * Releases every backing array and the cached matrix view.
+ */
+void Graph::releaseStorage() {
+    detach(false);
+    data->stride = 0;
+    vector<int, AlignedAllocator<int>>().swap(data->cells);
+    vector<int>().swap(data->rowOffsets);
+    vector<int>().swap(data->colTargets);
+    vector<int>().swap(data->edgeWeights);
+    data->bitWords = 0;
+    vector<uint64_t>().swap(data->bitRows);
+    invalidateView();
+}
+
+/**
+ * Applies op(weight, arg) to every stored edge of a sparse graph, dropping edges that become zero.
  *
- * @return True if the graph has negative weights.
+ * @param op The weight transformation.
+ * @param arg The second argument passed to op.
  */
-bool Graph::isGraphNegWeighted() {
-    for (int i = 0; i < this->getVertexNum(); ++i) {
-        for (int j = 0; j < this->getVertexNum(); ++j) {
-            if (this->getGraph()[i][j] < 0) {
-                return true;
+void Graph::mapSparseWeights(int (*op)(int, int), int arg) {
+    detach(true);
+    int out = 0;
+    for (int v = 0; v < data->numVer; ++v) {
+        int begin = data->rowOffsets[v];
+        data->rowOffsets[v] = out;
+        for (int pos = begin; pos < data->rowOffsets[v + 1]; ++pos) {
+            int weight = op(data->edgeWeights[pos], arg);
+            if (weight != 0) {
+                data->colTargets[out] = data->colTargets[pos];
+                data->edgeWeights[out] = weight;
+                ++out;
             }
         }
     }
-    return false;
+    data->rowOffsets[data->numVer] = out;
+    data->colTargets.resize(out);
+    data->edgeWeights.resize(out);
+    invalidateView();
+}
+
+/**
+ * Writes op(cell, arg) for every non-zero cell of the dense matrix into out, which has
+ * the same layout; zero cells stay zero. Rows are split across the shared thread pool.
+ *
+ * @param out The destination buffer; may be the matrix itself.
+ * @param op The weight transformation.
+ * @param arg The second argument passed to op.
+ */
+void Graph::mapDenseCells(int* out, int (*op)(int, int), int arg) const {
+    const int* in = data->cells.data();
+    size_t rowCells = static_cast<size_t>(data->stride);
+    ThreadPool::shared().parallelFor(0, data->numVer, data->stride, [=](int first, int last) {
+        for (size_t k = first * rowCells; k < last * rowCells; ++k) {
+            out[k] = in[k] != 0 ? op(in[k], arg) : 0;
+        }
+    });
+}
+
+/**
+ * Prints the graph's adjacency matrix.
+ */
+void Graph::printGraph() {
+    cout << *this;
+}
+
+/**
+ * Checks if the graph is directed. Cached; the matrix is scanned at most once per change.
+ *
+ * @return True if the graph is directed.
+ */
+bool Graph::isGraphDirected() const {
+    ensureProperties();
+    return data->isDirected;
+}
+
+/**
+ * Checks if the graph has weighted edges. Cached like isGraphDirected.
+ *
+ * @return True if the graph has weighted edges.
+ */
+bool Graph::isGraphWeighted() const {
+    ensureProperties();
+    return data->isWeighted;
+}
+
+/**
+ * Checks if the graph has negative weights. Cached like isGraphDirected.
+ *
+ * @return True if the graph has negative weights.
+ */
+bool Graph::isGraphNegWeighted() const {
+    ensureProperties();
+    return data->nonZeroCount > 0 && data->minWeight < 0;
 }
 
 // Getters
@@ -128,7 +688,7 @@ bool Graph::isGraphNegWeighted() {
  * @return The number of vertices.
  */
 int Graph::getVertexNum() const {
-    return numVer;
+    return data->numVer;
 }
 
 /**
@@ -137,7 +697,8 @@ int Graph::getVertexNum() const {
  * @return True if the graph is directed.
  */
 bool Graph::getIsDirected() const {
-    return isDirected;
+    ensureProperties();
+    return data->isDirected;
 }
 
 /**
@@ -146,7 +707,8 @@ bool Graph::getIsDirected() const {
  * @return True if the graph has weighted edges.
  */
 bool Graph::getIsWeighted() const {
-    return isWeighted;
+    ensureProperties();
+    return data->isWeighted;
 }
 
 /**
@@ -155,16 +717,217 @@ bool Graph::getIsWeighted() const {
  * @return True if the graph is empty.
  */
 bool Graph::getIsEmpty() const {
-    return numVer == 0;
+    return data->numVer == 0;
 }
 
 /**
- * Gets the adjacency matrix of the graph.
+ * Builds the incoming-edge CSR of a directed graph with a counting sort over
+ * the targets. Sources come out ascending because rows are visited in order.
+ * Does nothing if another thread built it first.
+ */
+void Graph::buildIncoming() const {
+    lock_guard<std::mutex> lock(data->cacheMutex);
+    if (data->incomingValid) {
+        return;
+    }
+    int numVer = data->numVer;
+    vector<int>& offsets = data->inOffsets;
+    offsets.assign(numVer + 1, 0);
+    for (int u = 0; u < numVer; ++u) {
+        int pos = edgeBegin(u), v, weight;
+        while (nextEdge(u, pos, v, weight)) {
+            ++offsets[v + 1];
+        }
+    }
+    for (int v = 0; v < numVer; ++v) {
+        offsets[v + 1] += offsets[v];
+    }
+    data->inSources.resize(offsets[numVer]);
+    data->inWeights.resize(offsets[numVer]);
+    vector<int> fill(offsets.begin(), offsets.end() - 1);
+    for (int u = 0; u < numVer; ++u) {
+        int pos = edgeBegin(u), v, weight;
+        while (nextEdge(u, pos, v, weight)) {
+            data->inSources[fill[v]] = u;
+            data->inWeights[fill[v]++] = weight;
+        }
+    }
+    data->incomingValid = true;
+}
+
+/**
+ * Builds the connectivity index with one union-find pass over every edge.
+ * Does nothing if another thread built it first.
+ */
+void Graph::buildComponents() const {
+    lock_guard<std::mutex> lock(data->cacheMutex);
+    if (data->componentsValid) {
+        return;
+    }
+    data->componentParent.assign(data->numVer, -1);
+    data->componentCount = data->numVer;
+    for (int u = 0; u < data->numVer; ++u) {
+        int pos = edgeBegin(u), v, weight;
+        while (nextEdge(u, pos, v, weight)) {
+            uniteComponents(u, v);
+        }
+    }
+    data->componentsValid = true;
+}
+
+/**
+ * Merges the trees of u and v in the connectivity index, hanging the smaller
+ * under the larger and halving the paths walked to the roots. Called only while
+ * the index is built under the cache lock, or by operator+= on data it owns.
+ */
+void Graph::uniteComponents(int u, int v) const {
+    vector<int>& parent = data->componentParent;
+    auto root = [&parent](int x) {
+        while (parent[x] >= 0) {
+            if (parent[parent[x]] >= 0) {
+                parent[x] = parent[parent[x]];
+            }
+            x = parent[x];
+        }
+        return x;
+    };
+    u = root(u);
+    v = root(v);
+    if (u == v) {
+        return;
+    }
+    if (parent[u] > parent[v]) {
+        std::swap(u, v);
+    }
+    parent[u] += parent[v];
+    parent[v] = u;
+    --data->componentCount;
+}
+
+/**
+ * Gets the number of connected components, ignoring edge directions.
+ *
+ * @return The component count; 0 for an empty graph.
+ */
+int Graph::getComponentCount() const {
+    if (!data->componentsValid) {
+        buildComponents();
+    }
+    return data->componentCount;
+}
+
+/**
+ * Checks if two vertices are connected, ignoring edge directions. The trees
+ * are kept balanced by size, so the lookup walks O(log V) parents without
+ * changing the index.
+ *
+ * @param u A vertex.
+ * @param v A vertex.
+ * @return True if a path joins u and v.
+ */
+bool Graph::sameComponent(int u, int v) const {
+    if (!data->componentsValid) {
+        buildComponents();
+    }
+    const vector<int>& parent = data->componentParent;
+    while (parent[u] >= 0) {
+        u = parent[u];
+    }
+    while (parent[v] >= 0) {
+        v = parent[v];
+    }
+    return u == v;
+}
+
+/**
+ * Gets the adjacency matrix of the graph as nested vectors. The view is built
+ * on first use and cached until the graph changes; hot paths should use
+ * getWeight or nextEdge instead.
  *
  * @return The adjacency matrix.
  */
 const vector<vector<int>>& Graph::getGraph() const {
-    return this->graph;
+    if (!data->matrixViewValid) {
+        lock_guard<std::mutex> lock(data->cacheMutex);
+        if (data->matrixViewValid) {
+            return data->matrixView;
+        }
+        data->matrixView.assign(data->numVer, vector<int>(data->numVer, 0));
+        for (int i = 0; i < data->numVer; ++i) {
+            if (data->storage == Storage::Dense) {
+                const int* row = &data->cells[static_cast<size_t>(i) * data->stride];
+                std::copy(row, row + data->numVer, data->matrixView[i].begin());
+            } else {
+                int pos = edgeBegin(i), j, weight;
+                while (nextEdge(i, pos, j, weight)) {
+                    data->matrixView[i][j] = weight;
+                }
+            }
+        }
+        data->matrixViewValid = true;
+    }
+    return data->matrixView;
+}
+
+/**
+ * Gets the backing store of the graph.
+ *
+ * @return Storage::Dense, Storage::Sparse or Storage::BitPacked.
+ */
+Storage Graph::getStorage() const {
+    return data->storage;
+}
+
+/**
+ * Checks if the graph is stored in compressed sparse rows.
+ *
+ * @return True if the graph uses the CSR backing store.
+ */
+bool Graph::isSparse() const {
+    return data->storage == Storage::Sparse;
+}
+
+/**
+ * Checks if the graph is stored as a bit matrix.
+ *
+ * @return True if the graph uses the bit-packed backing store.
+ */
+bool Graph::isBitPacked() const {
+    return data->storage == Storage::BitPacked;
+}
+
+/**
+ * Gets the number of 64-bit words in each row of the bit matrix.
+ * Only meaningful for bit-packed graphs; rows are read with getBitRow(v).
+ *
+ * @return The words per row.
+ */
+int Graph::getBitWords() const {
+    return data->bitWords;
+}
+
+/**
+ * Gets the weight of the edge u -> v, or 0 if there is no such edge.
+ * O(1) on the matrix and bit matrix, O(log deg(u)) on CSR.
+ *
+ * @param u The source vertex.
+ * @param v The target vertex.
+ * @return The edge weight.
+ */
+int Graph::getWeight(int u, int v) const {
+    if (data->storage == Storage::Dense) {
+        return data->cells[static_cast<size_t>(u) * data->stride + v];
+    }
+    if (data->storage == Storage::BitPacked) {
+        return static_cast<int>((data->bitRows[static_cast<size_t>(u) * data->bitWords + (v >> 6)] >> (v & 63)) & 1);
+    }
+    vector<int>::const_iterator first = data->colTargets.begin() + data->rowOffsets[u];
+    vector<int>::const_iterator last = data->colTargets.begin() + data->rowOffsets[u + 1];
+    vector<int>::const_iterator it = std::lower_bound(first, last, v);
+    if (it == last || *it != v) {
+        return 0;
+    }
+    return data->edgeWeights[it - data->colTargets.begin()];
 }
 
 /**
@@ -173,20 +936,25 @@ const vector<vector<int>>& Graph::getGraph() const {
  * @return The number of edges.
  */
 int Graph::getNumberOfEdges() const {
-    int numEdges = 0;
-    for (int i = 0; i < numVer; ++i) {
-        for (int j = 0; j < numVer; ++j) {
-            if (graph[i][j] != 0) {
-                numEdges++;
-            }
-        }
-    }
-    if (!isDirected) {
+    ensureProperties();
+    int numEdges = data->nonZeroCount;
+    if (!data->isDirected) {
         numEdges /= 2;
     }
     return numEdges;
 }
 
+/**
+ * Gets the number of edges leaving a vertex. Cached with the other properties.
+ *
+ * @param v The vertex.
+ * @return The out-degree of v.
+ */
+int Graph::getDegree(int v) const {
+    ensureProperties();
+    return data->degrees[v];
+}
+
 /**
  * Checks if two graphs have the same edges.
  *
@@ -194,14 +962,40 @@ int Graph::getNumberOfEdges() const {
  * @return True if the graphs have the same edges.
  */
 bool Graph::haveSameEdges(const Graph& graph1) const {
-    if (graph1.getVertexNum() != numVer) {
+    if (graph1.getVertexNum() != data->numVer) {
         return false;
     }
-    for (int i = 0; i < numVer; ++i) {
-        for (int j = 0; j < numVer; ++j) {
-            if (graph[i][j] != graph1.getGraph()[i][j]) {
+    if (data->storage == Storage::Dense && graph1.data->storage == Storage::Dense) {
+        // Same size means same stride, so the buffers compare directly, a block of rows per worker
+        const int* a = data->cells.data();
+        const int* b = graph1.data->cells.data();
+        size_t rowCells = static_cast<size_t>(data->stride);
+        std::atomic<bool> same(true);
+        ThreadPool::shared().parallelFor(0, data->numVer, data->stride, [&](int first, int last) {
+            if (same.load(std::memory_order_relaxed) && !std::equal(a + first * rowCells, a + last * rowCells, b + first * rowCells)) {
+                same.store(false, std::memory_order_relaxed);
+            }
+        });
+        return same.load();
+    }
+    if (data->storage == Storage::BitPacked && graph1.data->storage == Storage::BitPacked) {
+        return data->bitRows == graph1.data->bitRows;
+    }
+    // Walk both rows edge by edge; the graphs match when the edge sequences do.
+    for (int i = 0; i < data->numVer; ++i) {
+        int pos = edgeBegin(i), otherPos = graph1.edgeBegin(i);
+        int target, weight, otherTarget, otherWeight;
+        bool more = nextEdge(i, pos, target, weight);
+        bool otherMore = graph1.nextEdge(i, otherPos, otherTarget, otherWeight);
+        while (more && otherMore) {
+            if (target != otherTarget || weight != otherWeight) {
                 return false;
             }
+            more = nextEdge(i, pos, target, weight);
+            otherMore = graph1.nextEdge(i, otherPos, otherTarget, otherWeight);
+        }
+        if (more || otherMore) {
+            return false;
         }
     }
     return true;
@@ -230,6 +1024,26 @@ bool Graph::isSubmatrixMatch(const std::vector<std::vector<int>>& largerGraph, c
     return true;
 }
 
+/**
+ * Checks if this graph's matrix equals the block of a larger graph starting at (startRow, startCol).
+ * Works on any pair of backing stores without building getGraph() views.
+ *
+ * @param larger The larger graph.
+ * @param startRow The starting row.
+ * @param startCol The starting column.
+ * @return True if the block matches.
+ */
+bool Graph::matchesAt(const Graph& larger, int startRow, int startCol) const {
+    for (int i = 0; i < data->numVer; ++i) {
+        for (int j = 0; j < data->numVer; ++j) {
+            if (larger.getWeight(startRow + i, startCol + j) != getWeight(i, j)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
 // Function to check if the current graph is contained in another graph
 /**
  * Checks if the current graph is contained within another graph.
@@ -238,28 +1052,19 @@ bool Graph::isSubmatrixMatch(const std::vector<std::vector<int>>& largerGraph, c
  * @return True if the current graph is contained within the other graph.
  */
 bool Graph::isContainedIn(const Graph& other) const {
-    if (numVer > other.numVer) {
+    if (data->numVer > other.data->numVer) {
         return false;
     }
-    int a = 0;
-    if (numVer == other.numVer) {
-        for (int i = 0; i < numVer; ++i) {
-            for (int j = 0; j < numVer; ++j) {
-                if (graph[i][j] != other.graph[i][j]) {
-                    ++a;
-                }
-            }
-        }
-        if (a == 0) return false;
+    if (data->numVer == other.data->numVer && haveSameEdges(other)) {
+        return false;
     }
 
-    int subRows = numVer;
-    int subCols = numVer;
-    const auto& otherGraph = other.getGraph();
+    int subRows = data->numVer;
+    int subCols = data->numVer;
 
-    for (int i = 0; i <= other.numVer - subRows; ++i) {
-        for (int j = 0; j <= other.numVer - subCols; ++j) {
-            if (isSubmatrixMatch(otherGraph, graph, i, j)) {
+    for (int i = 0; i <= other.data->numVer - subRows; ++i) {
+        for (int j = 0; j <= other.data->numVer - subCols; ++j) {
+            if (matchesAt(other, i, j)) {
                 return true;
             }
         }
@@ -285,15 +1090,182 @@ Graph Graph::operator+() const {
  * @return The resulting graph.
  * @throws invalid_argument if the graphs are not the same size.
  */
-Graph Graph::operator+(const Graph& other) const {
-    if (numVer != other.numVer) {
+Graph Graph::operator+(const Graph& other) const & {
+    if (data->numVer != other.data->numVer) {
         throw invalid_argument("Graphs must be of the same size to add.");
     }
-    Graph result(graph, isDirected, isWeighted, numVer);
-    for (int i = 0; i < numVer; ++i) {
-        for (int j = 0; j < numVer; ++j) {
-            result.graph[i][j] = graph[i][j] + other.graph[i][j];
+    if (data->storage == Storage::Sparse && other.data->storage == Storage::Sparse) {
+        return sparseCombine(other, 1);
+    }
+    return denseCombine(other, 1);
+}
+
+/**
+ * Adds a graph to a temporary, reusing the temporary's storage for the result.
+ *
+ * @param other The graph to add.
+ * @return The resulting graph.
+ * @throws invalid_argument if the graphs are not the same size.
+ */
+Graph Graph::operator+(const Graph& other) && {
+    *this += other;
+    return std::move(*this);
+}
+
+/**
+ * Adds sign * other to this graph in place. Matrix storage is updated cell by cell
+ * with rows split across the thread pool; two sparse graphs are merged instead,
+ * since the CSR layout changes. A sparse or bit-packed graph combined with a
+ * matrix becomes a matrix, as with the binary operators. When adding, the
+ * connectivity index survives and takes in the added edges.
+ *
+ * @param other The second operand, of the same size; may be this graph.
+ * @param sign 1 to add, -1 to subtract.
+ */
+void Graph::accumulate(const Graph& other, int sign) {
+    // Adding edges only merges components, so a valid connectivity index is
+    // carried over and extended below instead of rebuilt
+    vector<int> componentParent;
+    int componentCount = 0;
+    bool extendIndex = sign > 0 && data->componentsValid;
+    if (extendIndex) {
+        // Other copies sharing the data keep their index
+        if (data.use_count() == 1) {
+            componentParent.swap(data->componentParent);
+            data->componentsValid = false;
+        } else {
+            componentParent = data->componentParent;
+        }
+        componentCount = data->componentCount;
+    }
+    if (data->storage == Storage::Sparse && other.data->storage == Storage::Sparse) {
+        *this = sparseCombine(other, sign);
+    } else {
+        accumulateDense(other, sign);
+    }
+    if (extendIndex) {
+        data->componentParent.swap(componentParent);
+        data->componentCount = componentCount;
+        data->componentsValid = true;
+        // A cell of other that sums to zero removed an edge; the index can only
+        // be rebuilt then
+        for (int i = 0; i < data->numVer && data->componentsValid; ++i) {
+            int pos = other.edgeBegin(i), j, weight;
+            while (other.nextEdge(i, pos, j, weight)) {
+                if (getWeight(i, j) == 0) {
+                    invalidateView();
+                    break;
+                }
+                uniteComponents(i, j);
+            }
+        }
+    }
+}
+
+/**
+ * Adds sign * other to this graph's matrix in place (see accumulate).
+ *
+ * @param other The second operand, of the same size; may be this graph.
+ * @param sign 1 to add, -1 to subtract.
+ */
+void Graph::accumulateDense(const Graph& other, int sign) {
+    toDense();
+    detach(true);
+    int* out = data->cells.data();
+    int width = data->stride;
+    if (other.data->storage == Storage::Dense) {
+        const int* in = other.data->cells.data();
+        ThreadPool::shared().parallelFor(0, data->numVer, width, [=](int first, int last) {
+            for (size_t k = static_cast<size_t>(first) * width; k < static_cast<size_t>(last) * width; ++k) {
+                out[k] += sign * in[k];
+            }
+        });
+    } else {
+        ThreadPool::shared().parallelFor(0, data->numVer, width, [&](int first, int last) {
+            for (int i = first; i < last; ++i) {
+                int* row = out + static_cast<size_t>(i) * width;
+                int pos = other.edgeBegin(i), j, weight;
+                while (other.nextEdge(i, pos, j, weight)) {
+                    row[j] += sign * weight;
+                }
+            }
+        });
+    }
+    invalidateView();
+    invalidateProperties();
+}
+
+/**
+ * Computes this + sign * other into a matrix-backed graph. Operands may use any backing store.
+ *
+ * @param other The second operand, of the same size.
+ * @param sign 1 to add, -1 to subtract.
+ * @return The resulting graph.
+ */
+Graph Graph::denseCombine(const Graph& other, int sign) const {
+    Graph result = emptyResult(Storage::Dense);
+    int* out = result.data->cells.data();
+    int outStride = result.data->stride;
+    if (data->storage == Storage::Dense && other.data->storage == Storage::Dense) {
+        // Equal sizes share a stride: one linear sweep over both buffers
+        const int* a = data->cells.data();
+        const int* b = other.data->cells.data();
+        ThreadPool::shared().parallelFor(0, data->numVer, outStride, [=](int first, int last) {
+            for (size_t k = static_cast<size_t>(first) * outStride; k < static_cast<size_t>(last) * outStride; ++k) {
+                out[k] = a[k] + sign * b[k];
+            }
+        });
+        return result;
+    }
+    ThreadPool::shared().parallelFor(0, data->numVer, outStride, [&](int first, int last) {
+        for (int i = first; i < last; ++i) {
+            int* row = out + static_cast<size_t>(i) * outStride;
+            int pos = edgeBegin(i), j, weight;
+            while (nextEdge(i, pos, j, weight)) {
+                row[j] = weight;
+            }
+            pos = other.edgeBegin(i);
+            while (other.nextEdge(i, pos, j, weight)) {
+                row[j] += sign * weight;
+            }
         }
+    });
+    return result;
+}
+
+/**
+ * Computes this + sign * other for two sparse graphs by merging their sorted rows.
+ * Entries that cancel out are dropped. Runs in O(V + E).
+ *
+ * @param other The second operand, of the same size.
+ * @param sign 1 to add, -1 to subtract.
+ * @return The resulting sparse graph.
+ */
+Graph Graph::sparseCombine(const Graph& other, int sign) const {
+    Graph result = emptyResult(Storage::Sparse);
+    result.data->colTargets.reserve(data->colTargets.size() + other.data->colTargets.size());
+    result.data->edgeWeights.reserve(data->colTargets.size() + other.data->colTargets.size());
+    for (int i = 0; i < data->numVer; ++i) {
+        int a = data->rowOffsets[i], aEnd = data->rowOffsets[i + 1];
+        int b = other.data->rowOffsets[i], bEnd = other.data->rowOffsets[i + 1];
+        while (a < aEnd || b < bEnd) {
+            int target, weight;
+            if (b == bEnd || (a < aEnd && data->colTargets[a] < other.data->colTargets[b])) {
+                target = data->colTargets[a];
+                weight = data->edgeWeights[a++];
+            } else if (a == aEnd || other.data->colTargets[b] < data->colTargets[a]) {
+                target = other.data->colTargets[b];
+                weight = sign * other.data->edgeWeights[b++];
+            } else {
+                target = data->colTargets[a];
+                weight = data->edgeWeights[a++] + sign * other.data->edgeWeights[b++];
+            }
+            if (weight != 0) {
+                result.data->colTargets.push_back(target);
+                result.data->edgeWeights.push_back(weight);
+            }
+        }
+        result.data->rowOffsets[i + 1] = static_cast<int>(result.data->colTargets.size());
     }
     return result;
 }
@@ -303,9 +1275,13 @@ Graph Graph::operator+(const Graph& other) const {
  *
  * @param other The graph to add.
  * @return The current graph after addition.
+ * @throws invalid_argument if the graphs are not the same size.
  */
 Graph& Graph::operator+=(const Graph& other) {
-    *this = *this + other;
+    if (data->numVer != other.data->numVer) {
+        throw invalid_argument("Graphs must be of the same size to add.");
+    }
+    accumulate(other, 1);
     return *this;
 }
 
@@ -314,16 +1290,35 @@ Graph& Graph::operator+=(const Graph& other) {
  *
  * @return The resulting graph with negated weights.
  */
-Graph Graph::operator-() const {
-    Graph result(graph, isDirected, isWeighted, numVer);
-    for (int i = 0; i < numVer; ++i) {
-        for (int j = 0; j < numVer; ++j) {
-            result.graph[i][j] = -graph[i][j];
-        }
+Graph Graph::operator-() const & {
+    if (data->storage == Storage::Sparse) {
+        Graph result = *this;
+        result.mapSparseWeights(scaleWeight, -1);
+        result.scaleProperties(*this, -1);
+        return result;
+    }
+    if (data->storage == Storage::BitPacked) {
+        // -1 weights do not fit in bits
+        Graph dense = *this;
+        dense.toDense();
+        return -dense;
     }
+    Graph result = emptyResult(Storage::Dense);
+    mapDenseCells(result.data->cells.data(), scaleWeight, -1);
+    result.scaleProperties(*this, -1);
     return result;
 }
 
+/**
+ * Negates a temporary in place.
+ *
+ * @return The resulting graph with negated weights.
+ */
+Graph Graph::operator-() && {
+    *this *= -1;
+    return std::move(*this);
+}
+
 /**
  * Subtracts another graph from the current graph.
  *
@@ -331,17 +1326,26 @@ Graph Graph::operator-() const {
  * @return The resulting graph after subtraction.
  * @throws invalid_argument if the graphs are not the same size.
  */
-Graph Graph::operator-(const Graph& other) const {
-    if (numVer != other.numVer) {
+Graph Graph::operator-(const Graph& other) const & {
+    if (data->numVer != other.data->numVer) {
         throw invalid_argument("Graphs must be of the same size to subtract.");
     }
-    Graph result(graph, isDirected, isWeighted, numVer);
-    for (int i = 0; i < numVer; ++i) {
-        for (int j = 0; j < numVer; ++j) {
-            result.graph[i][j] = graph[i][j] - other.graph[i][j];
-        }
+    if (data->storage == Storage::Sparse && other.data->storage == Storage::Sparse) {
+        return sparseCombine(other, -1);
     }
-    return result;
+    return denseCombine(other, -1);
+}
+
+/**
+ * Subtracts a graph from a temporary, reusing the temporary's storage for the result.
+ *
+ * @param other The graph to subtract.
+ * @return The resulting graph after subtraction.
+ * @throws invalid_argument if the graphs are not the same size.
+ */
+Graph Graph::operator-(const Graph& other) && {
+    *this -= other;
+    return std::move(*this);
 }
 
 /**
@@ -349,9 +1353,13 @@ Graph Graph::operator-(const Graph& other) const {
  *
  * @param other The graph to subtract.
  * @return The current graph after subtraction.
+ * @throws invalid_argument if the graphs are not the same size.
  */
 Graph& Graph::operator-=(const Graph& other) {
-    *this = *this - other;
+    if (data->numVer != other.data->numVer) {
+        throw invalid_argument("Graphs must be of the same size to subtract.");
+    }
+    accumulate(other, -1);
     return *this;
 }
 
@@ -372,7 +1380,7 @@ bool Graph::operator>(const Graph& other) const {
     }
     if (this->getNumberOfEdges() > other.getNumberOfEdges()) {
         return true;
-    } else if (numVer > other.numVer) {
+    } else if (data->numVer > other.data->numVer) {
         return true;
     }
 
@@ -394,7 +1402,7 @@ bool Graph::operator<(const Graph& other) const {
     }
     if (this->getNumberOfEdges() < other.getNumberOfEdges()) {
         return true;
-    } else if (this->getNumberOfEdges() == other.getNumberOfEdges() && numVer < other.numVer) {
+    } else if (this->getNumberOfEdges() == other.getNumberOfEdges() && data->numVer < other.data->numVer) {
         return true;
     }
     return false;
@@ -454,13 +1462,19 @@ bool Graph::operator<=(const Graph& other) const {
  * @return The incremented graph.
  */
 Graph& Graph::operator++() {
-    for (int i = 0; i < numVer; ++i) {
-        for (int j = 0; j < numVer; ++j) {
-            if (graph[i][j] != 0) {
-                ++graph[i][j];
-            }
-        }
+    if (data->storage == Storage::Sparse) {
+        mapSparseWeights(addWeight, 1);
+        shiftProperties(1);
+        return *this;
     }
+    if (data->storage == Storage::BitPacked) {
+        // Every weight becomes 2, which needs the int matrix
+        toDense();
+    }
+    detach(true);
+    mapDenseCells(data->cells.data(), addWeight, 1);
+    invalidateView();
+    shiftProperties(1);
     return *this;
 }
 
@@ -481,13 +1495,23 @@ const Graph Graph::operator++(int) {
  * @return The decremented graph.
  */
 Graph& Graph::operator--() {
-    for (int i = 0; i < numVer; ++i) {
-        for (int j = 0; j < numVer; ++j) {
-            if (graph[i][j] != 0) {
-                --graph[i][j];
-            }
-        }
+    if (data->storage == Storage::Sparse) {
+        mapSparseWeights(addWeight, -1);
+        shiftProperties(-1);
+        return *this;
+    }
+    if (data->storage == Storage::BitPacked) {
+        // Every weight is 1, so every edge disappears
+        detach(true);
+        std::fill(data->bitRows.begin(), data->bitRows.end(), 0);
+        invalidateView();
+        shiftProperties(-1);
+        return *this;
     }
+    detach(true);
+    mapDenseCells(data->cells.data(), addWeight, -1);
+    invalidateView();
+    shiftProperties(-1);
     return *this;
 }
 
@@ -510,40 +1534,354 @@ const Graph Graph::operator--(int) {
  * @param scalar The scalar to multiply by.
  * @return The resulting graph.
  */
-Graph Graph::operator*(int scalar) const {
-    Graph result(graph, isDirected, isWeighted, numVer);
-    for (int i = 0; i < numVer; ++i) {
-        for (int j = 0; j < numVer; ++j) {
-            result.graph[i][j] = graph[i][j] * scalar;
-        }
+Graph Graph::operator*(int scalar) const & {
+    if (data->storage == Storage::Sparse) {
+        Graph result = *this;
+        result.mapSparseWeights(scaleWeight, scalar);
+        result.scaleProperties(*this, scalar);
+        return result;
+    }
+    if (data->storage == Storage::BitPacked) {
+        Graph dense = *this;
+        dense.toDense();
+        return dense * scalar;
     }
+    Graph result = emptyResult(Storage::Dense);
+    mapDenseCells(result.data->cells.data(), scaleWeight, scalar);
+    result.scaleProperties(*this, scalar);
     return result;
 }
 
+/**
+ * Multiplies the edge weights of a temporary in place.
+ *
+ * @param scalar The scalar to multiply by.
+ * @return The resulting graph.
+ */
+Graph Graph::operator*(int scalar) && {
+    *this *= scalar;
+    return std::move(*this);
+}
+
+/**
+ * Multiplies all edge weights by a scalar value in place.
+ *
+ * @param scalar The scalar to multiply by.
+ * @return The current graph after multiplication.
+ */
+Graph& Graph::operator*=(int scalar) {
+    if (data->storage == Storage::Sparse) {
+        mapSparseWeights(scaleWeight, scalar);
+    } else {
+        // Bit-packed weights cannot hold the scaled values
+        toDense();
+        detach(true);
+        mapDenseCells(data->cells.data(), scaleWeight, scalar);
+        invalidateView();
+    }
+    scaleProperties(*this, scalar);
+    return *this;
+}
+
+/**
+ * Divides all edge weights by a scalar value in place, rounding toward zero.
+ * Edges whose weight becomes zero are removed.
+ *
+ * @param scalar The scalar to divide by.
+ * @return The current graph after division.
+ * @throws invalid_argument if scalar is zero.
+ */
+Graph& Graph::operator/=(int scalar) {
+    if (scalar == 0) {
+        throw invalid_argument("Division by zero is not allowed.");
+    }
+    if (data->storage == Storage::Sparse) {
+        mapSparseWeights(divideWeight, scalar);
+    } else {
+        toDense();
+        detach(true);
+        mapDenseCells(data->cells.data(), divideWeight, scalar);
+        invalidateView();
+    }
+    invalidateProperties();
+    return *this;
+}
+
 // Graph multiplication
 
 /**
- * Multiplies two graphs using matrix multiplication.
+ * Decides whether this * other is cheaper through the sparse product. The matrix
+ * kernels spend about V multiply-adds per edge of this graph, the sparse one about
+ * the average out-degree of other plus hashing overhead, so the sparse product wins
+ * once other is less than 1/64 full.
+ *
+ * @param other The right operand, of the same size.
+ * @return True to convert both operands to CSR and multiply them sparsely.
+ */
+bool Graph::prefersSparseProduct(const Graph& other) const {
+    if (data->numVer < 64) {
+        return false;
+    }
+    other.ensureProperties();
+    return static_cast<long long>(other.data->nonZeroCount) * 64 < static_cast<long long>(data->numVer) * data->numVer;
+}
+
+/**
+ * Multiplies two sparse graphs row by row (Gustavson): row i of the result sums the
+ * rows k of other weighted by this[i][k]. Rows are handed to the thread pool in
+ * blocks. A row with few candidate products accumulates in a small hash table;
+ * a row with many uses a dense scratch row. Work is proportional to the number of
+ * products, never to V².
+ *
+ * @param other The right operand, sparse and of the same size.
+ * @param wideAccumulate True to reject result cells that do not fit in an int.
+ * @return The sparse product.
+ * @throws overflow_error if wideAccumulate is set and a result cell overflows.
+ */
+Graph Graph::sparseMultiply(const Graph& other, bool wideAccumulate) const {
+    const int blockRows = 1024;
+    int blocks = (data->numVer + blockRows - 1) / blockRows;
+    long long products = 0;
+    for (int k : data->colTargets) {
+        products += other.data->rowOffsets[k + 1] - other.data->rowOffsets[k];
+    }
+    vector<vector<int>> blockTargets(blocks);
+    vector<vector<int>> blockWeights(blocks);
+    vector<int> rowLengths(data->numVer, 0);
+    ThreadPool::shared().parallelFor(0, blocks, products / std::max(blocks, 1) + 1, [&](int firstBlock, int lastBlock) {
+        vector<long long> values;
+        vector<int> marks;
+        vector<int> columns;
+        vector<int> hashKeys;
+        vector<long long> hashValues;
+        vector<pair<int, long long>> entries;
+        for (int block = firstBlock; block < lastBlock; ++block) {
+            vector<int>& targets = blockTargets[block];
+            vector<int>& weights = blockWeights[block];
+            int last = std::min(data->numVer, (block + 1) * blockRows);
+            for (int i = block * blockRows; i < last; ++i) {
+                int bound = 0;
+                for (int a = data->rowOffsets[i]; a < data->rowOffsets[i + 1]; ++a) {
+                    bound += other.data->rowOffsets[data->colTargets[a] + 1] - other.data->rowOffsets[data->colTargets[a]];
+                }
+                if (bound == 0) {
+                    continue;
+                }
+                entries.clear();
+                if (bound < data->numVer / 32) {
+                    // Open addressing over a power-of-two table at most half full
+                    size_t capacity = 16;
+                    while (capacity < 2 * static_cast<size_t>(bound)) {
+                        capacity <<= 1;
+                    }
+                    if (hashKeys.size() < capacity) {
+                        hashKeys.resize(capacity);
+                        hashValues.resize(capacity);
+                    }
+                    std::fill(hashKeys.begin(), hashKeys.begin() + capacity, -1);
+                    size_t mask = capacity - 1;
+                    for (int a = data->rowOffsets[i]; a < data->rowOffsets[i + 1]; ++a) {
+                        int k = data->colTargets[a];
+                        for (int b = other.data->rowOffsets[k]; b < other.data->rowOffsets[k + 1]; ++b) {
+                            int j = other.data->colTargets[b];
+                            size_t slot = (static_cast<size_t>(j) * 2654435761u) & mask;
+                            while (hashKeys[slot] != -1 && hashKeys[slot] != j) {
+                                slot = (slot + 1) & mask;
+                            }
+                            if (hashKeys[slot] == -1) {
+                                hashKeys[slot] = j;
+                                hashValues[slot] = 0;
+                            }
+                            hashValues[slot] += static_cast<long long>(data->edgeWeights[a]) * other.data->edgeWeights[b];
+                        }
+                    }
+                    for (size_t slot = 0; slot < capacity; ++slot) {
+                        if (hashKeys[slot] != -1) {
+                            entries.push_back(make_pair(hashKeys[slot], hashValues[slot]));
+                        }
+                    }
+                } else {
+                    if (marks.empty()) {
+                        values.assign(data->numVer, 0);
+                        marks.assign(data->numVer, -1);
+                    }
+                    columns.clear();
+                    for (int a = data->rowOffsets[i]; a < data->rowOffsets[i + 1]; ++a) {
+                        int k = data->colTargets[a];
+                        for (int b = other.data->rowOffsets[k]; b < other.data->rowOffsets[k + 1]; ++b) {
+                            int j = other.data->colTargets[b];
+                            if (marks[j] != i) {
+                                marks[j] = i;
+                                values[j] = 0;
+                                columns.push_back(j);
+                            }
+                            values[j] += static_cast<long long>(data->edgeWeights[a]) * other.data->edgeWeights[b];
+                        }
+                    }
+                    for (int j : columns) {
+                        entries.push_back(make_pair(j, values[j]));
+                    }
+                }
+                std::sort(entries.begin(), entries.end());
+                for (const pair<int, long long>& entry : entries) {
+                    int weight = narrowProduct(entry.second, wideAccumulate);
+                    if (weight != 0) {
+                        targets.push_back(entry.first);
+                        weights.push_back(weight);
+                        ++rowLengths[i];
+                    }
+                }
+            }
+        }
+    });
+
+    Graph result = emptyResult(Storage::Sparse);
+    for (int i = 0; i < data->numVer; ++i) {
+        result.data->rowOffsets[i + 1] = result.data->rowOffsets[i] + rowLengths[i];
+    }
+    result.data->colTargets.resize(result.data->rowOffsets[data->numVer]);
+    result.data->edgeWeights.resize(result.data->rowOffsets[data->numVer]);
+    ThreadPool::shared().parallelFor(0, blocks, products / std::max(blocks, 1) + 1, [&](int firstBlock, int lastBlock) {
+        for (int block = firstBlock; block < lastBlock; ++block) {
+            int offset = result.data->rowOffsets[block * blockRows];
+            std::copy(blockTargets[block].begin(), blockTargets[block].end(), result.data->colTargets.begin() + offset);
+            std::copy(blockWeights[block].begin(), blockWeights[block].end(), result.data->edgeWeights.begin() + offset);
+        }
+    });
+    return result;
+}
+
+/**
+ * Multiplies two graphs using matrix multiplication, accumulating in int.
  *
  * @param other The graph to multiply with.
  * @return The resulting graph.
  * @throws invalid_argument if the graphs are not the same size.
  */
 Graph Graph::operator*(const Graph& other) const {
-    if (numVer != other.numVer) {
+    return multiply(other, false);
+}
+
+/**
+ * Multiplies two graphs using matrix multiplication. Two matrix-backed graphs
+ * use the cache-blocked kernel, vectorised with AVX2 when the CPU has it.
+ *
+ * @param other The graph to multiply with.
+ * @param wideAccumulate True to accumulate in 64 bits and reject cells that do not fit in an int.
+ * @return The resulting graph.
+ * @throws invalid_argument if the graphs are not the same size.
+ * @throws overflow_error if wideAccumulate is set and a result cell overflows.
+ */
+Graph Graph::multiply(const Graph& other, bool wideAccumulate) const {
+    if (data->numVer != other.data->numVer) {
         throw invalid_argument("Graphs must be of the same size to multiply.");
     }
-    Graph result(vector<vector<int>>(numVer, vector<int>(numVer, 0)), isDirected, isWeighted, numVer);
-    for (int i = 0; i < numVer; ++i) {
-        for (int j = 0; j < numVer; ++j) {
-            for (int k = 0; k < numVer; ++k) {
-                result.graph[i][j] += graph[i][k] * other.graph[k][j];
+    if (data->storage == Storage::Sparse && other.data->storage == Storage::Sparse) {
+        return sparseMultiply(other, wideAccumulate);
+    }
+    if (prefersSparseProduct(other)) {
+        // Mostly-empty matrices: multiply as CSR, then hand back the usual matrix result
+        Graph left = *this;
+        Graph right = other;
+        left.toSparse();
+        right.toSparse();
+        Graph product = left.sparseMultiply(right, wideAccumulate);
+        product.toDense();
+        return product;
+    }
+    Graph result = emptyResult(Storage::Dense);
+    int* out = result.data->cells.data();
+    if (data->storage == Storage::BitPacked && other.data->storage == Storage::BitPacked) {
+        // result[i][j] counts the k with i -> k and k -> j: the popcount of
+        // row i of this AND column j of other, read as a row of its transpose.
+        vector<uint64_t> columns(data->bitRows.size(), 0);
+        for (int k = 0; k < data->numVer; ++k) {
+            int pos = other.edgeBegin(k), j, weight;
+            while (other.nextEdge(k, pos, j, weight)) {
+                columns[static_cast<size_t>(j) * data->bitWords + (k >> 6)] |= uint64_t(1) << (k & 63);
             }
         }
+        int outStride = result.data->stride;
+        ThreadPool::shared().parallelFor(0, data->numVer, static_cast<long long>(data->numVer) * data->bitWords, [&](int first, int last) {
+            for (int i = first; i < last; ++i) {
+                const uint64_t* row = &data->bitRows[static_cast<size_t>(i) * data->bitWords];
+                for (int j = 0; j < data->numVer; ++j) {
+                    const uint64_t* column = &columns[static_cast<size_t>(j) * data->bitWords];
+                    int count = 0;
+                    for (int w = 0; w < data->bitWords; ++w) {
+                        count += __builtin_popcountll(row[w] & column[w]);
+                    }
+                    out[static_cast<size_t>(i) * outStride + j] = count;
+                }
+            }
+        });
+        return result;
+    }
+    if (data->storage != Storage::Dense || other.data->storage != Storage::Dense) {
+        // Mixed backends: only the non-zero products contribute.
+        int outStride = result.data->stride;
+        ThreadPool::shared().parallelFor(0, data->numVer, static_cast<long long>(data->numVer) * data->numVer, [&](int first, int last) {
+            vector<long long> accumulator(data->numVer);
+            for (int i = first; i < last; ++i) {
+                std::fill(accumulator.begin(), accumulator.end(), 0);
+                int a = edgeBegin(i), k, weight;
+                while (nextEdge(i, a, k, weight)) {
+                    int b = other.edgeBegin(k), j, otherWeight;
+                    while (other.nextEdge(k, b, j, otherWeight)) {
+                        accumulator[j] += static_cast<long long>(weight) * otherWeight;
+                    }
+                }
+                for (int j = 0; j < data->numVer; ++j) {
+                    out[static_cast<size_t>(i) * outStride + j] = narrowProduct(accumulator[j], wideAccumulate);
+                }
+            }
+        });
+        return result;
+    }
+    bool avx2 = cpuHasAvx2();
+    const int* a = data->cells.data();
+    const int* b = other.data->cells.data();
+    int n = data->numVer, width = data->stride;
+    // Workers take whole row blocks so their tiles never overlap
+    int blocks = (data->numVer + productRowBlock - 1) / productRowBlock;
+    long long blockWork = static_cast<long long>(productRowBlock) * data->numVer * data->numVer;
+    if (wideAccumulate) {
+        void (*kernel)(long long*, const int*, int, int) = addScaledRow;
+#if defined(__x86_64__) || defined(__i386__)
+        if (avx2) {
+            kernel = addScaledRowAvx2;
+        }
+#endif
+        ThreadPool::shared().parallelFor(0, blocks, blockWork, [=](int first, int last) {
+            blockedMultiply(a, b, out, n, width, first * productRowBlock, std::min(n, last * productRowBlock), kernel, true);
+        });
+    } else {
+        void (*kernel)(int*, const int*, int, int) = addScaledRow;
+#if defined(__x86_64__) || defined(__i386__)
+        if (avx2) {
+            kernel = addScaledRowAvx2;
+        }
+#endif
+        ThreadPool::shared().parallelFor(0, blocks, blockWork, [=](int first, int last) {
+            blockedMultiply(a, b, out, n, width, first * productRowBlock, std::min(n, last * productRowBlock), kernel, false);
+        });
     }
     return result;
 }
 
+/**
+ * Multiplies this graph by another graph. The product cannot be formed in the
+ * operands' storage, so the result is moved in rather than copied.
+ *
+ * @param other The graph to multiply with.
+ * @return The current graph after multiplication.
+ * @throws invalid_argument if the graphs are not the same size.
+ */
+Graph& Graph::operator*=(const Graph& other) {
+    *this = multiply(other, false);
+    return *this;
+}
+
 // Output operator
 
 /**
@@ -554,9 +1892,9 @@ Graph Graph::operator*(const Graph& other) const {
  * @return The output stream.
  */
 ostream& operator<<(ostream& os, const Graph& g) {
-    for (int i = 0; i < g.numVer; ++i) {
-        for (int j = 0; j < g.numVer; ++j) {
-            os << g.graph[i][j] << " ";
+    for (int i = 0; i < g.data->numVer; ++i) {
+        for (int j = 0; j < g.data->numVer; ++j) {
+            os << g.getWeight(i, j) << " ";
         }
         os << endl;
     }
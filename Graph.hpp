@@ -3,14 +3,115 @@
 #pragma once
 #include <vector>
 #include <iostream>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include "AlignedAllocator.hpp"
 using namespace std;
 
-class Graph {
-private:
+// Backing store of a Graph: a V x V adjacency matrix, compressed sparse rows
+// (rowOffsets/colTargets/edgeWeights) whose size scales with the number of edges,
+// or, for unweighted graphs, a matrix packed to one bit per cell.
+enum class Storage { Dense, Sparse, BitPacked };
+
+// Lazy arithmetic expression over graphs, defined in GraphExpr.hpp.
+template <typename E>
+class GraphExpr;
+
+/**
+ * Everything a Graph stores: the backing arrays and the caches derived from them.
+ * Graph copies share one GraphData through a reference count; a graph takes its
+ * own copy only when it is about to change (copy-on-write). The caches are filled
+ * in from const queries, so all copies of a graph benefit from them.
+ */
+struct GraphData {
     int numVer;
+    Storage storage;
+
+    // Properties derived from the edges, computed together in one sweep on
+    // first use and kept until the edges change. Operators that can predict
+    // them (negation, scaling, ++/-- that removes no edge) update them in place.
+    std::atomic<bool> propertiesValid;
     bool isDirected;
     bool isWeighted;
-    vector<vector<int>> graph;
+    int minWeight;
+    int maxWeight;
+    int nonZeroCount;
+    vector<int> degrees;
+
+    // Matrix cells, row-major in one aligned buffer. Row i starts at i * stride;
+    // the stride is padded to whole cache lines and the padding stays zero.
+    int stride;
+    vector<int, AlignedAllocator<int>> cells;
+
+    // CSR arrays, used when storage == Storage::Sparse. Row v occupies
+    // [rowOffsets[v], rowOffsets[v + 1]) with targets sorted ascending.
+    vector<int> rowOffsets;
+    vector<int> colTargets;
+    vector<int> edgeWeights;
+
+    // Bit matrix, used when storage == Storage::BitPacked. Row v is
+    // bitWords 64-bit words starting at bitRows[v * bitWords]; bit j of the
+    // row is set when v -> j is an edge. Bits past numVer stay zero.
+    int bitWords;
+    vector<uint64_t> bitRows;
+
+    // Nested-vector copy of the matrix built on demand by getGraph().
+    vector<vector<int>> matrixView;
+    std::atomic<bool> matrixViewValid;
+
+    // Incoming edges of a directed graph as CSR (the transpose), built on demand
+    // by inEdgeBegin() and kept until the edges change. Row v lists the sources
+    // u of the edges u -> v in ascending order.
+    vector<int> inOffsets;
+    vector<int> inSources;
+    vector<int> inWeights;
+    std::atomic<bool> incomingValid;
+
+    // Connectivity index: a union-find forest over the edges taken as undirected.
+    // componentParent[v] is the parent of v, or minus the size of the tree at a
+    // root. Built on demand; operator+= merges the added edges in, and any other
+    // change drops it.
+    vector<int> componentParent;
+    int componentCount;
+    std::atomic<bool> componentsValid;
+
+    // Serialises building the caches above from const methods, so copies that
+    // share this data can be queried from several threads. Each flag is set
+    // only once its cache is complete; readers that see it set skip the lock.
+    std::mutex cacheMutex;
+
+    GraphData();
+    GraphData(const GraphData& other, bool copyStorage);
+};
+
+class Graph {
+private:
+    std::shared_ptr<GraphData> data;
+
+    void detach(bool copyStorage);
+    void computeProperties() const;
+    void ensureProperties() const;
+    void invalidateProperties();
+    void shiftProperties(int delta);
+    void scaleProperties(const Graph& source, int factor);
+    void resetDense(int vertices);
+    void invalidateView();
+    void buildIncoming() const;
+    void buildComponents() const;
+    void uniteComponents(int u, int v) const;
+    Graph emptyResult(Storage resultStorage) const;
+    void releaseStorage();
+    void mapSparseWeights(int (*op)(int, int), int arg);
+    void mapDenseCells(int* out, int (*op)(int, int), int arg) const;
+    Graph sparseCombine(const Graph& other, int sign) const;
+    Graph denseCombine(const Graph& other, int sign) const;
+    void accumulate(const Graph& other, int sign);
+    void accumulateDense(const Graph& other, int sign);
+    bool prefersSparseProduct(const Graph& other) const;
+    Graph sparseMultiply(const Graph& other, bool wideAccumulate) const;
+    bool matchesAt(const Graph& larger, int startRow, int startCol) const;
 
 public:
     //Constructor
@@ -19,7 +120,23 @@ public:
     //default constructor
     Graph();
 
+    // Copies share the data in O(1); whichever copy changes first takes its own.
+    Graph(const Graph& other);
+    Graph(Graph&& other) noexcept;
+    Graph& operator=(const Graph& other);
+    Graph& operator=(Graph&& other) noexcept;
+
+    // Evaluates a lazy expression (see GraphExpr.hpp) in one fused pass into a new matrix.
+    template <typename E>
+    Graph(const GraphExpr<E>& expression);
+    template <typename E>
+    Graph& operator=(const GraphExpr<E>& expression);
+
     void loadGraph(const vector<vector<int>>& newGraph);
+    void loadSparseGraph(int vertices, const vector<int>& offsets, const vector<int>& targets, const vector<int>& weights);
+    void toSparse();
+    void toDense();
+    void toBitPacked();
     void printGraph();
 
     //Getters
@@ -29,21 +146,51 @@ public:
     bool getIsWeighted() const;
     bool getIsEmpty() const;
     const std::vector<std::vector<int>>& getGraph() const;
-    bool isGraphDirected();
-    bool isGraphWeighted();
-    bool isGraphNegWeighted();
+    Storage getStorage() const;
+    bool isSparse() const;
+    bool isBitPacked() const;
+    int getBitWords() const;
+    const uint64_t* getBitRow(int v) const;
+    const int* getDenseRow(int v) const;
+    int getWeight(int u, int v) const;
+
+    // Neighbour cursor: start with pos = edgeBegin(v) and call nextEdge until it
+    // returns false. Works on both backends, so traversals cost O(deg) on CSR.
+    int edgeBegin(int v) const;
+    bool nextEdge(int v, int& pos, int& target, int& weight) const;
+
+    // Incoming-edge cursor over the edges u -> v: start with pos = inEdgeBegin(v)
+    // and call nextInEdge until it returns false. Undirected graphs walk their
+    // own rows; directed ones build the transposed CSR on first use.
+    int inEdgeBegin(int v) const;
+    bool nextInEdge(int v, int& pos, int& source, int& weight) const;
+
+    // Connectivity index over the edges taken as undirected (the weakly connected
+    // components of a directed graph), built on first use. operator+= merges the
+    // added edges in, so both queries stay near-constant while a graph grows;
+    // changes that may remove an edge rebuild the index on the next query.
+    int getComponentCount() const;
+    bool sameComponent(int u, int v) const;
+    bool isGraphDirected() const;
+    bool isGraphWeighted() const;
+    bool isGraphNegWeighted() const;
     int getNumberOfEdges() const;
+    int getDegree(int v) const;
     bool haveSameEdges(const Graph& graph1)const;
     bool isContainedIn(const Graph& other) const;
     bool isSubmatrixMatch(const std::vector<std::vector<int>>& largerGraph, const std::vector<std::vector<int>>& subGraph, int startRow, int startCol)const;
 
 
-    // Arithmetic operators
+    // Arithmetic operators. Compound assignments update the matrix in place; the
+    // && overloads reuse a temporary left operand, so a + b + c allocates once.
     Graph operator+() const;
-    Graph operator+(const Graph& other) const;
+    Graph operator+(const Graph& other) const &;
+    Graph operator+(const Graph& other) &&;
     Graph& operator+=(const Graph& other);
-    Graph operator-() const;
-    Graph operator-(const Graph& other) const;
+    Graph operator-() const &;
+    Graph operator-() &&;
+    Graph operator-(const Graph& other) const &;
+    Graph operator-(const Graph& other) &&;
     Graph& operator-=(const Graph& other);
 
     // Comparison operators
@@ -61,15 +208,94 @@ public:
     const Graph operator--(int);  // Postfix decrement
 
     // Scalar multiplication
-    Graph operator*(int scalar) const;
+    Graph operator*(int scalar) const &;
+    Graph operator*(int scalar) &&;
+    Graph& operator*=(int scalar);
+    Graph& operator/=(int scalar);
 
     // Graph multiplication
     Graph operator*(const Graph& other) const;
+    Graph& operator*=(const Graph& other);
+    Graph multiply(const Graph& other, bool wideAccumulate) const;
 
     // Output operator
     friend std::ostream& operator<<(std::ostream& os, const Graph& graph);
 };
 
+inline const uint64_t* Graph::getBitRow(int v) const {
+    return &data->bitRows[static_cast<size_t>(v) * data->bitWords];
+}
+
+inline const int* Graph::getDenseRow(int v) const {
+    return data->storage == Storage::Dense ? &data->cells[static_cast<size_t>(v) * data->stride] : nullptr;
+}
+
+inline int Graph::inEdgeBegin(int v) const {
+    if (!isGraphDirected()) {
+        return edgeBegin(v);
+    }
+    if (!data->incomingValid) {
+        buildIncoming();
+    }
+    return data->inOffsets[v];
+}
+
+inline bool Graph::nextInEdge(int v, int& pos, int& source, int& weight) const {
+    if (!data->isDirected) {
+        return nextEdge(v, pos, source, weight);
+    }
+    if (pos >= data->inOffsets[v + 1]) {
+        return false;
+    }
+    source = data->inSources[pos];
+    weight = data->inWeights[pos];
+    ++pos;
+    return true;
+}
+
+inline int Graph::edgeBegin(int v) const {
+    return data->storage == Storage::Sparse ? data->rowOffsets[v] : 0;
+}
+
+inline bool Graph::nextEdge(int v, int& pos, int& target, int& weight) const {
+    if (data->storage == Storage::Sparse) {
+        if (pos >= data->rowOffsets[v + 1]) {
+            return false;
+        }
+        target = data->colTargets[pos];
+        weight = data->edgeWeights[pos];
+        ++pos;
+        return true;
+    }
+    if (data->storage == Storage::BitPacked) {
+        // Skip whole empty words, then jump to the lowest set bit
+        const uint64_t* row = &data->bitRows[static_cast<size_t>(v) * data->bitWords];
+        while (pos < data->numVer) {
+            uint64_t word = row[pos >> 6] >> (pos & 63);
+            if (word != 0) {
+                pos += __builtin_ctzll(word);
+                target = pos;
+                weight = 1;
+                ++pos;
+                return true;
+            }
+            pos = (pos | 63) + 1;
+        }
+        return false;
+    }
+    const int* row = &data->cells[static_cast<size_t>(v) * data->stride];
+    while (pos < data->numVer) {
+        if (row[pos] != 0) {
+            target = pos;
+            weight = row[pos];
+            ++pos;
+            return true;
+        }
+        ++pos;
+    }
+    return false;
+}
+
 
 
 
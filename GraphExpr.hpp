@@ -0,0 +1,255 @@
+// Nadav034@gmail.com
+
+#pragma once
+#include "Graph.hpp"
+#include "ThreadPool.hpp"
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+
+/**
+ * Lazy element-wise graph arithmetic. lazy(g) starts an expression; +, -, unary -
+ * and * by a scalar then build a small tree of nodes instead of temporary graphs.
+ * Assigning the tree to a Graph evaluates every cell in one pass over the rows,
+ * into a single new matrix:
+ *
+ *     Graph blended = lazy(g1) + g2 - lazy(g3) * 2;
+ *
+ * Only subexpressions rooted at lazy() are fused: g3 * 2 on its own would be an
+ * eager operator that builds a temporary graph first.
+ *
+ * Size mismatches throw std::invalid_argument when the expression is built, as the
+ * eager operators do. Nodes refer to their graphs, so an expression must be
+ * evaluated before the graphs it names go away; the graph product stays eager.
+ *
+ * Every node provides getVertexNum() and a Cursor: cursor.seek(v) moves to row v and
+ * cursor.at(j) returns cell (v, j) of the expression.
+ */
+template <typename E>
+class GraphExpr {
+public:
+    const E& self() const {
+        return static_cast<const E&>(*this);
+    }
+};
+
+/**
+ * Leaf node: one graph. Matrix rows are read in place; sparse and bit-packed rows
+ * are expanded into a scratch row owned by the cursor.
+ */
+class GraphTerm : public GraphExpr<GraphTerm> {
+public:
+    explicit GraphTerm(const Graph& graph) : graph(graph) {}
+
+    int getVertexNum() const {
+        return graph.getVertexNum();
+    }
+
+    class Cursor {
+    public:
+        explicit Cursor(const Graph& graph) : graph(graph), row(nullptr) {}
+
+        void seek(int v) {
+            row = graph.getDenseRow(v);
+            if (row == nullptr) {
+                scratch.assign(graph.getVertexNum(), 0);
+                int pos = graph.edgeBegin(v), j, weight;
+                while (graph.nextEdge(v, pos, j, weight)) {
+                    scratch[j] = weight;
+                }
+                row = scratch.data();
+            }
+        }
+
+        int at(int j) const {
+            return row[j];
+        }
+
+    private:
+        const Graph& graph;
+        const int* row;
+        std::vector<int> scratch;
+    };
+
+    Cursor cursor() const {
+        return Cursor(graph);
+    }
+
+private:
+    const Graph& graph;
+};
+
+/**
+ * left + sign * right, for sign 1 (addition) or -1 (subtraction).
+ */
+template <typename L, typename R>
+class GraphSum : public GraphExpr<GraphSum<L, R>> {
+public:
+    /**
+     * @throws std::invalid_argument if the operands are not the same size.
+     */
+    GraphSum(const L& left, const R& right, int sign) : left(left), right(right), sign(sign) {
+        if (left.getVertexNum() != right.getVertexNum()) {
+            throw std::invalid_argument(sign > 0 ? "Graphs must be of the same size to add."
+                                                 : "Graphs must be of the same size to subtract.");
+        }
+    }
+
+    int getVertexNum() const {
+        return left.getVertexNum();
+    }
+
+    class Cursor {
+    public:
+        Cursor(const typename L::Cursor& left, const typename R::Cursor& right, int sign)
+            : left(left), right(right), sign(sign) {}
+
+        void seek(int v) {
+            left.seek(v);
+            right.seek(v);
+        }
+
+        int at(int j) const {
+            return left.at(j) + sign * right.at(j);
+        }
+
+    private:
+        typename L::Cursor left;
+        typename R::Cursor right;
+        int sign;
+    };
+
+    Cursor cursor() const {
+        return Cursor(left.cursor(), right.cursor(), sign);
+    }
+
+private:
+    L left;
+    R right;
+    int sign;
+};
+
+/**
+ * operand * factor; unary minus is a factor of -1.
+ */
+template <typename E>
+class GraphScaled : public GraphExpr<GraphScaled<E>> {
+public:
+    GraphScaled(const E& operand, int factor) : operand(operand), factor(factor) {}
+
+    int getVertexNum() const {
+        return operand.getVertexNum();
+    }
+
+    class Cursor {
+    public:
+        Cursor(const typename E::Cursor& operand, int factor) : operand(operand), factor(factor) {}
+
+        void seek(int v) {
+            operand.seek(v);
+        }
+
+        int at(int j) const {
+            return operand.at(j) * factor;
+        }
+
+    private:
+        typename E::Cursor operand;
+        int factor;
+    };
+
+    Cursor cursor() const {
+        return Cursor(operand.cursor(), factor);
+    }
+
+private:
+    E operand;
+    int factor;
+};
+
+/**
+ * Starts a lazy expression on a graph.
+ *
+ * @param graph The graph; it must outlive the expression.
+ * @return The leaf node for graph.
+ */
+inline GraphTerm lazy(const Graph& graph) {
+    return GraphTerm(graph);
+}
+
+template <typename L, typename R>
+GraphSum<L, R> operator+(const GraphExpr<L>& left, const GraphExpr<R>& right) {
+    return GraphSum<L, R>(left.self(), right.self(), 1);
+}
+
+template <typename L>
+GraphSum<L, GraphTerm> operator+(const GraphExpr<L>& left, const Graph& right) {
+    return GraphSum<L, GraphTerm>(left.self(), GraphTerm(right), 1);
+}
+
+template <typename R>
+GraphSum<GraphTerm, R> operator+(const Graph& left, const GraphExpr<R>& right) {
+    return GraphSum<GraphTerm, R>(GraphTerm(left), right.self(), 1);
+}
+
+template <typename L, typename R>
+GraphSum<L, R> operator-(const GraphExpr<L>& left, const GraphExpr<R>& right) {
+    return GraphSum<L, R>(left.self(), right.self(), -1);
+}
+
+template <typename L>
+GraphSum<L, GraphTerm> operator-(const GraphExpr<L>& left, const Graph& right) {
+    return GraphSum<L, GraphTerm>(left.self(), GraphTerm(right), -1);
+}
+
+template <typename R>
+GraphSum<GraphTerm, R> operator-(const Graph& left, const GraphExpr<R>& right) {
+    return GraphSum<GraphTerm, R>(GraphTerm(left), right.self(), -1);
+}
+
+template <typename E>
+GraphScaled<E> operator-(const GraphExpr<E>& operand) {
+    return GraphScaled<E>(operand.self(), -1);
+}
+
+template <typename E>
+GraphScaled<E> operator*(const GraphExpr<E>& operand, int factor) {
+    return GraphScaled<E>(operand.self(), factor);
+}
+
+/**
+ * Evaluates an expression into a new matrix-backed graph, one row per step, with
+ * rows split across the shared thread pool. Each worker walks its own cursor.
+ *
+ * @param expression The expression to evaluate.
+ */
+template <typename E>
+Graph::Graph(const GraphExpr<E>& expression) : Graph() {
+    const E& root = expression.self();
+    resetDense(root.getVertexNum());
+    int* out = data->cells.data();
+    int n = data->numVer, width = data->stride;
+    ThreadPool::shared().parallelFor(0, n, width, [&](int first, int last) {
+        typename E::Cursor cursor = root.cursor();
+        for (int i = first; i < last; ++i) {
+            cursor.seek(i);
+            int* row = out + static_cast<size_t>(i) * width;
+            for (int j = 0; j < n; ++j) {
+                row[j] = cursor.at(j);
+            }
+        }
+    });
+}
+
+/**
+ * Evaluates an expression and stores the result in this graph. The expression may
+ * name this graph: it is evaluated into a fresh matrix before the assignment.
+ *
+ * @param expression The expression to evaluate.
+ * @return This graph.
+ */
+template <typename E>
+Graph& Graph::operator=(const GraphExpr<E>& expression) {
+    *this = Graph(expression);
+    return *this;
+}
@@ -0,0 +1,211 @@
+// Nadav034@gmail.com
+
+#pragma once
+#include <vector>
+#include <utility>
+#include <limits>
+
+/**
+ * Min-priority queue over the vertices 0..n-1 with decrease-key, stored as an
+ * implicit D-ary heap. Each vertex is queued at most once, so the heap never
+ * holds more than n entries, and a position table finds a queued vertex in O(1).
+ * Entries keep their key next to the vertex so sifting reads one array.
+ */
+template <int D = 4>
+class IndexedDaryHeap {
+public:
+    /**
+     * @param vertices The number of vertices that may be queued.
+     */
+    explicit IndexedDaryHeap(int vertices) : position(vertices, -1) {}
+
+    bool empty() const { return heap.empty(); }
+    bool contains(int v) const { return position[v] != -1; }
+    int minKey() const { return heap.front().first; }
+
+    /**
+     * Queues v with the given key, or lowers its key if it is already queued.
+     * A key that is not lower than the queued one is ignored.
+     */
+    void update(int v, int key) {
+        int i = position[v];
+        if (i == -1) {
+            i = static_cast<int>(heap.size());
+            heap.push_back(Entry(key, v));
+        } else if (key < heap[i].first) {
+            heap[i].first = key;
+        } else {
+            return;
+        }
+        siftUp(i);
+    }
+
+    /**
+     * Removes the vertex with the smallest key.
+     *
+     * @return The removed vertex.
+     */
+    int pop() {
+        int v = heap.front().second;
+        position[v] = -1;
+        Entry last = heap.back();
+        heap.pop_back();
+        if (!heap.empty()) {
+            heap.front() = last;
+            siftDown(0);
+        }
+        return v;
+    }
+
+private:
+    typedef std::pair<int, int> Entry;   // key, vertex
+
+    std::vector<Entry> heap;
+    std::vector<int> position;           // index in heap, or -1 when not queued
+
+    void siftUp(int i) {
+        Entry moving = heap[i];
+        while (i > 0) {
+            int parent = (i - 1) / D;
+            if (heap[parent].first <= moving.first) {
+                break;
+            }
+            heap[i] = heap[parent];
+            position[heap[i].second] = i;
+            i = parent;
+        }
+        heap[i] = moving;
+        position[moving.second] = i;
+    }
+
+    void siftDown(int i) {
+        Entry moving = heap[i];
+        int size = static_cast<int>(heap.size());
+        while (true) {
+            int first = i * D + 1;
+            if (first >= size) {
+                break;
+            }
+            int last = first + D < size ? first + D : size;
+            int best = first;
+            for (int c = first + 1; c < last; ++c) {
+                if (heap[c].first < heap[best].first) {
+                    best = c;
+                }
+            }
+            if (moving.first <= heap[best].first) {
+                break;
+            }
+            heap[i] = heap[best];
+            position[heap[i].second] = i;
+            i = best;
+        }
+        heap[i] = moving;
+        position[moving.second] = i;
+    }
+};
+
+/**
+ * Monotone min-priority queue for non-negative integer keys (a radix heap).
+ * Bucket 0 holds the keys equal to the last removed minimum and bucket b > 0
+ * the keys whose highest bit differing from it is bit b - 1. When bucket 0
+ * runs dry, the smallest key of the first non-empty bucket becomes the new
+ * minimum and that bucket is spread over the lower ones; each key can only
+ * move down, so it is touched at most 33 times.
+ *
+ * Keys must never be lower than the last removed minimum, which holds in
+ * Dijkstra's algorithm with non-negative weights. Like IndexedDaryHeap, each
+ * vertex is queued at most once and update() lowers the key of a queued vertex.
+ */
+class RadixHeap {
+public:
+    /**
+     * @param vertices The number of vertices that may be queued.
+     */
+    explicit RadixHeap(int vertices)
+        : keys(vertices, 0), bucketOf(vertices, -1), slot(vertices, 0), buckets(Buckets), lastMin(0), count(0) {}
+
+    bool empty() const { return count == 0; }
+    bool contains(int v) const { return bucketOf[v] != -1; }
+
+    /**
+     * Queues v with the given key, or lowers its key if it is already queued.
+     * A key that is not lower than the queued one is ignored.
+     */
+    void update(int v, int key) {
+        unsigned int k = static_cast<unsigned int>(key);
+        if (bucketOf[v] != -1) {
+            if (k >= keys[v]) {
+                return;
+            }
+            unlink(v);
+        } else {
+            ++count;
+        }
+        keys[v] = k;
+        link(v);
+    }
+
+    /**
+     * Removes a vertex with the smallest key.
+     *
+     * @return The removed vertex.
+     */
+    int pop() {
+        if (buckets[0].empty()) {
+            int b = 1;
+            while (buckets[b].empty()) {
+                ++b;
+            }
+            std::vector<int>& source = buckets[b];
+            unsigned int smallest = std::numeric_limits<unsigned int>::max();
+            for (int v : source) {
+                if (keys[v] < smallest) {
+                    smallest = keys[v];
+                }
+            }
+            lastMin = smallest;
+            // Relinking from a swapped-out copy keeps source free for later use
+            spill.swap(source);
+            for (int v : spill) {
+                link(v);
+            }
+            spill.clear();
+        }
+        int v = buckets[0].back();
+        buckets[0].pop_back();
+        bucketOf[v] = -1;
+        --count;
+        return v;
+    }
+
+private:
+    static const int Buckets = 33;
+
+    std::vector<unsigned int> keys;
+    std::vector<int> bucketOf;              // bucket holding the vertex, or -1 when not queued
+    std::vector<int> slot;                  // index inside that bucket
+    std::vector<std::vector<int>> buckets;
+    std::vector<int> spill;
+    unsigned int lastMin;
+    int count;
+
+    int bucketFor(unsigned int key) const {
+        return key == lastMin ? 0 : 32 - __builtin_clz(key ^ lastMin);
+    }
+
+    void link(int v) {
+        int b = bucketFor(keys[v]);
+        bucketOf[v] = b;
+        slot[v] = static_cast<int>(buckets[b].size());
+        buckets[b].push_back(v);
+    }
+
+    void unlink(int v) {
+        std::vector<int>& bucket = buckets[bucketOf[v]];
+        int moved = bucket.back();
+        bucket[slot[v]] = moved;
+        slot[moved] = slot[v];
+        bucket.pop_back();
+    }
+};
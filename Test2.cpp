@@ -4,7 +4,14 @@
 #include "Algorithms.hpp"
 #include <vector>
 #include "Graph.hpp"
+#include "ThreadPool.hpp"
+#include "GraphExpr.hpp"
+#include "DepthFirstSearch.hpp"
+#include "PriorityQueues.hpp"
 #include <sstream>
+#include <atomic>
+#include <algorithm>
+#include <thread>
 
 using namespace std;
 
@@ -434,3 +441,1743 @@ TEST_CASE("Test operations on large graphs") {
 
 
 
+TEST_CASE("Test sparse storage") {
+    // 0 - 1 - 2 path, stored as compressed sparse rows
+    Graph g1;
+    g1.loadSparseGraph(3, {0, 1, 3, 4}, {1, 0, 2, 1}, {1, 1, 1, 1});
+    CHECK(g1.isSparse());
+    CHECK(g1.getNumberOfEdges() == 2);
+    CHECK(!g1.getIsDirected());
+    CHECK(g1.getWeight(1, 2) == 1);
+    CHECK(g1.getWeight(0, 2) == 0);
+
+    vector<vector<int>> graph = {
+            {0, 1, 0},
+            {1, 0, 1},
+            {0, 1, 0}
+    };
+    CHECK(g1.getGraph() == graph);
+
+    Graph g2;
+    vector<vector<int>> weightedGraph = {
+            {0, 1, 1},
+            {1, 0, 2},
+            {1, 2, 0}
+    };
+    g2.loadGraph(weightedGraph);
+    Graph g3 = g2;
+    g3.toSparse();
+    CHECK(g3.haveSameEdges(g2));
+
+    // Sparse and mixed operands give the same results as the matrix form
+    Graph dense;
+    dense.loadGraph(graph);
+    CHECK((g1 + g3).getGraph() == (dense + g2).getGraph());
+    CHECK((g3 - g1).getGraph() == (g2 - dense).getGraph());
+    CHECK((g1 * g3).getGraph() == (dense * g2).getGraph());
+    CHECK((g1 * g2).getGraph() == (dense * g2).getGraph());
+    CHECK((g3 * 2).getGraph() == (g2 * 2).getGraph());
+    CHECK((g1 - g1).getNumberOfEdges() == 0);
+    CHECK((g1 + g3).isSparse());
+
+    --g1;
+    CHECK(g1.getNumberOfEdges() == 0);
+    g3.toDense();
+    CHECK(!g3.isSparse());
+    CHECK(g3.getGraph() == weightedGraph);
+
+    CHECK_THROWS_AS(g1.loadSparseGraph(2, {0, 2, 1}, {0, 1, 0}, {1, 1, 1}), std::invalid_argument);
+    CHECK_THROWS_AS(g1.loadSparseGraph(2, {0, 2, 2}, {1, 0}, {1, 1}), std::invalid_argument);
+    // Offsets past the end of targets are rejected before any row is read
+    CHECK_THROWS_AS(g1.loadSparseGraph(2, {0, 5, 3}, {0, 1, 0}, {1, 1, 1}), std::invalid_argument);
+    CHECK_THROWS_AS(g1.loadSparseGraph(2, {0, 1, 3}, {1, 0}, {1, 1}), std::invalid_argument);
+    CHECK_THROWS_AS(g1.loadSparseGraph(2, {1, 1, 2}, {1, 0}, {1, 1}), std::invalid_argument);
+    CHECK_THROWS_AS(g1.loadSparseGraph(2, {0, 1}, {1}, {1}), std::invalid_argument);
+    CHECK_THROWS_AS(g1.loadSparseGraph(2, {0, 1, 2}, {1, 0}, {1}), std::invalid_argument);
+}
+
+TEST_CASE("Test matrix copies and views") {
+    Graph g1;
+    vector<vector<int>> graph = {
+            {0, 1, 0},
+            {1, 0, 1},
+            {0, 1, 0}
+    };
+    g1.loadGraph(graph);
+    CHECK(g1.getGraph() == graph);
+
+    Graph g2 = g1;
+    ++g1;
+    vector<vector<int>> expectedIncrementedGraph = {
+            {0, 2, 0},
+            {2, 0, 2},
+            {0, 2, 0}
+    };
+    // The cached view follows changes, and copies own their cells
+    CHECK(g1.getGraph() == expectedIncrementedGraph);
+    CHECK(g2.getGraph() == graph);
+
+    g2 = g1;
+    CHECK(g2.getGraph() == expectedIncrementedGraph);
+    CHECK(g1.getWeight(0, 1) == 2);
+    CHECK(g1.getWeight(0, 2) == 0);
+}
+
+TEST_CASE("Test cached graph properties") {
+    Graph g1;
+    vector<vector<int>> graph = {
+            {0, 1, 0},
+            {0, 0, 1},
+            {1, 0, 0}
+    };
+    g1.loadGraph(graph);
+    CHECK(g1.isGraphDirected());
+    CHECK(!g1.isGraphWeighted());
+    CHECK(g1.getNumberOfEdges() == 3);
+    CHECK(g1.getDegree(1) == 1);
+
+    // Properties follow the edges through the operators
+    Graph g2 = -g1;
+    CHECK(g2.isGraphNegWeighted());
+    CHECK(g2.isGraphWeighted());
+    ++g2;
+    CHECK(g2.getNumberOfEdges() == 0);
+    CHECK(!g2.isGraphNegWeighted());
+
+    ++g1;
+    CHECK(g1.isGraphWeighted());
+    CHECK(g1.getNumberOfEdges() == 3);
+
+    Graph g3 = g1 + g1 * 0;
+    CHECK(g3.getNumberOfEdges() == 3);
+    Graph g4 = g1 - g1;
+    CHECK(g4.getNumberOfEdges() == 0);
+    CHECK(!g4.isGraphDirected());
+    CHECK(g4.getDegree(0) == 0);
+}
+
+TEST_CASE("Test bit-packed storage") {
+    Graph g1;
+    vector<vector<int>> graph = {
+            {0, 1, 0},
+            {1, 0, 1},
+            {0, 1, 0}
+    };
+    g1.loadGraph(graph);
+    Graph g2 = g1;
+    g2.toBitPacked();
+    CHECK(g2.isBitPacked());
+    CHECK(g2.getGraph() == graph);
+    CHECK(g2.haveSameEdges(g1));
+    CHECK(g2.getNumberOfEdges() == 2);
+    CHECK(g2.getWeight(2, 1) == 1);
+
+    CHECK((g2 * g2).getGraph() == (g1 * g1).getGraph());
+    CHECK((g2 + g2).getGraph() == (g1 + g1).getGraph());
+    CHECK((-g2).getGraph() == (-g1).getGraph());
+
+    Graph g3 = g2;
+    --g3;
+    CHECK(g3.getNumberOfEdges() == 0);
+    ++g2;
+    CHECK(!g2.isBitPacked());
+    CHECK(g2.getWeight(0, 1) == 2);
+
+    // Weighted graphs cannot be packed into bits
+    CHECK_THROWS_AS(g2.toBitPacked(), std::invalid_argument);
+
+    // Rows wider than one 64-bit word
+    const int size = 100;
+    vector<vector<int>> ring(size, vector<int>(size, 0));
+    for (int i = 0; i < size; ++i) {
+        ring[i][(i + 1) % size] = 1;
+        ring[(i + 1) % size][i] = 1;
+    }
+    Graph g4;
+    g4.loadGraph(ring);
+    Graph g5 = g4;
+    g5.toBitPacked();
+    CHECK((g5 * g5).getGraph() == (g4 * g4).getGraph());
+    g5.toSparse();
+    CHECK(g5.haveSameEdges(g4));
+}
+
+TEST_CASE("Test blocked graph multiplication") {
+    // Larger than one tile in every dimension, with negative weights
+    const int size = 300;
+    vector<vector<int>> matrix(size, vector<int>(size, 0));
+    for (int i = 0; i < size; ++i) {
+        for (int j = 0; j < size; ++j) {
+            if ((i * 7 + j * 3) % 5 == 0) {
+                matrix[i][j] = (i + 2 * j) % 9 - 4;
+            }
+        }
+    }
+    Graph g1;
+    g1.loadGraph(matrix);
+    vector<vector<int>> expected(size, vector<int>(size, 0));
+    for (int i = 0; i < size; ++i) {
+        for (int k = 0; k < size; ++k) {
+            for (int j = 0; j < size; ++j) {
+                expected[i][j] += matrix[i][k] * matrix[k][j];
+            }
+        }
+    }
+    CHECK((g1 * g1).getGraph() == expected);
+    CHECK(g1.multiply(g1, true).getGraph() == expected);
+    Graph g2 = g1;
+    g2.toSparse();
+    CHECK((g2 * g1).getGraph() == expected);
+    CHECK((g2 * g2).getGraph() == expected);
+
+    // 64-bit accumulation reports cells that do not fit in an int
+    Graph g3;
+    vector<vector<int>> heavy = {
+            {0, 50000},
+            {50000, 0}
+    };
+    g3.loadGraph(heavy);
+    CHECK_THROWS_AS(g3.multiply(g3, true), std::overflow_error);
+    g3.toSparse();
+    CHECK_THROWS_AS(g3.multiply(g3, true), std::overflow_error);
+}
+
+TEST_CASE("Test parallel operators") {
+    const int size = 150;
+    vector<vector<int>> first(size, vector<int>(size, 0));
+    vector<vector<int>> second(size, vector<int>(size, 0));
+    for (int i = 0; i < size; ++i) {
+        for (int j = 0; j < size; ++j) {
+            if ((i + j) % 3 == 0) {
+                first[i][j] = (i * j) % 7 - 3;
+            }
+            if ((i * j) % 4 == 1) {
+                second[i][j] = (i + j) % 5 + 1;
+            }
+        }
+    }
+    Graph g1, g2;
+    g1.loadGraph(first);
+    g2.loadGraph(second);
+
+    ThreadPool& pool = ThreadPool::shared();
+    int threads = pool.getThreadCount();
+    long long minWork = pool.getMinParallelWork();
+    pool.setThreadCount(1);
+    Graph sum = g1 + g2, difference = g1 - g2, negated = -g1, scaled = g1 * 3, product = g1 * g2;
+    Graph incremented = g1, decremented = g1;
+    ++incremented;
+    --decremented;
+    Graph sparse = g2;
+    sparse.toSparse();
+    Graph mixed = g1 * sparse;
+
+    // Split even the smallest loops across four threads
+    pool.setThreadCount(4);
+    pool.setMinParallelWork(1);
+    CHECK(pool.getThreadCount() == 4);
+    CHECK((g1 + g2).getGraph() == sum.getGraph());
+    CHECK((g1 - g2).getGraph() == difference.getGraph());
+    CHECK((-g1).getGraph() == negated.getGraph());
+    CHECK((g1 * 3).getGraph() == scaled.getGraph());
+    CHECK((g1 * g2).getGraph() == product.getGraph());
+    CHECK((g1 * sparse).getGraph() == mixed.getGraph());
+    Graph g3 = g1;
+    ++g3;
+    CHECK(g3.haveSameEdges(incremented));
+    g3 = g1;
+    --g3;
+    CHECK(g3.haveSameEdges(decremented));
+    CHECK_FALSE(g1.haveSameEdges(g2));
+
+    Graph heavy;
+    heavy.loadGraph(vector<vector<int>>(size, vector<int>(size, 50000)));
+    CHECK_THROWS_AS(heavy.multiply(heavy, true), std::overflow_error);
+    CHECK_THROWS_AS(pool.setThreadCount(-1), std::invalid_argument);
+
+    pool.setThreadCount(threads);
+    pool.setMinParallelWork(minWork);
+}
+
+TEST_CASE("Test sparse graph multiplication") {
+    // Friend-of-friend on a large ring: i reaches i - 2, i (twice) and i + 2 in two steps
+    const int size = 200000;
+    vector<int> offsets(1, 0), targets, weights;
+    for (int i = 0; i < size; ++i) {
+        int left = (i + size - 1) % size, right = (i + 1) % size;
+        targets.push_back(std::min(left, right));
+        targets.push_back(std::max(left, right));
+        weights.push_back(1);
+        weights.push_back(1);
+        offsets.push_back(static_cast<int>(targets.size()));
+    }
+    Graph ring;
+    ring.loadSparseGraph(size, offsets, targets, weights);
+    Graph square = ring * ring;
+    CHECK(square.isSparse());
+    CHECK(square.getWeight(5, 5) == 2);
+    CHECK(square.getWeight(5, 7) == 1);
+    CHECK(square.getWeight(5, 6) == 0);
+    CHECK(square.getWeight(0, size - 2) == 1);
+    CHECK(square.getNumberOfEdges() == size * 3 / 2);
+
+    // A hub row takes the dense accumulator, the other rows the hash table; cancelling products are dropped
+    const int hubSize = 300;
+    vector<vector<int>> matrix(hubSize, vector<int>(hubSize, 0));
+    for (int j = 1; j < hubSize; ++j) {
+        matrix[0][j] = j % 2 == 0 ? 1 : -1;
+        matrix[j][(j * 7) % hubSize] = 2;
+    }
+    matrix[5][3] = 1;
+    vector<vector<int>> expected(hubSize, vector<int>(hubSize, 0));
+    for (int i = 0; i < hubSize; ++i) {
+        for (int k = 0; k < hubSize; ++k) {
+            for (int j = 0; j < hubSize; ++j) {
+                expected[i][j] += matrix[i][k] * matrix[k][j];
+            }
+        }
+    }
+    Graph dense;
+    dense.loadGraph(matrix);
+    Graph sparse = dense;
+    sparse.toSparse();
+    CHECK((sparse * sparse).getGraph() == expected);
+    CHECK((sparse * sparse).getNumberOfEdges() == (sparse * dense).getNumberOfEdges());
+    // Mostly-empty matrices are multiplied sparsely but still return a matrix
+    Graph product = dense * dense;
+    CHECK(product.getStorage() == Storage::Dense);
+    CHECK(product.getGraph() == expected);
+}
+
+TEST_CASE("Test lazy graph expressions") {
+    Graph g1, g2, g3;
+    vector<vector<int>> graph1 = {
+            {0, 1, 0},
+            {1, 0, 1},
+            {0, 1, 0}
+    };
+    vector<vector<int>> graph2 = {
+            {0, 2, 3},
+            {2, 0, 0},
+            {3, 0, 0}
+    };
+    vector<vector<int>> graph3 = {
+            {0, 1, 1},
+            {0, 0, 1},
+            {1, 0, 0}
+    };
+    g1.loadGraph(graph1);
+    g2.loadGraph(graph2);
+    g3.loadGraph(graph3);
+
+    // One fused pass gives the same matrix as the eager operators
+    Graph fused = lazy(g1) + g2 - lazy(g3) * 2;
+    Graph eager = g1 + g2 - g3 * 2;
+    CHECK(fused.getGraph() == eager.getGraph());
+    CHECK(fused.getIsDirected());
+    Graph negated = -(lazy(g1) - g2);
+    CHECK(negated.getGraph() == (-(g1 - g2)).getGraph());
+    Graph scaled = g1 + lazy(g2) * 3;
+    CHECK(scaled.getGraph() == (g1 + g2 * 3).getGraph());
+
+    // Any backing store, and expressions that name the graph they are assigned to
+    g3.toSparse();
+    Graph g4 = g1;
+    g4.toBitPacked();
+    Graph mixed = lazy(g3) + g4 - g2;
+    CHECK(mixed.getGraph() == (g3 + g1 - g2).getGraph());
+    g1 = lazy(g1) + g1;
+    CHECK(g1.getGraph() == (g4 * 2).getGraph());
+
+    Graph g5;
+    g5.loadGraph({{0, 1}, {1, 0}});
+    CHECK_THROWS_AS(lazy(g1) + g5, std::invalid_argument);
+    CHECK_THROWS_AS(lazy(g1) - g5, std::invalid_argument);
+}
+
+TEST_CASE("Test in-place and rvalue operators") {
+    Graph g1, g2;
+    vector<vector<int>> graph1 = {
+            {0, 1, 0},
+            {1, 0, 1},
+            {0, 1, 0}
+    };
+    vector<vector<int>> graph2 = {
+            {0, 2, 3},
+            {2, 0, 0},
+            {3, 0, 0}
+    };
+    g1.loadGraph(graph1);
+    g2.loadGraph(graph2);
+
+    // Compound assignments write into the existing matrix
+    Graph g3;
+    g3.loadGraph(graph1);
+    const int* buffer = g3.getDenseRow(0);
+    g3 += g2;
+    CHECK(g3.getDenseRow(0) == buffer);
+    CHECK(g3.getGraph() == (g1 + g2).getGraph());
+    g3 -= g2;
+    CHECK(g3.haveSameEdges(g1));
+    g3 *= -2;
+    CHECK(g3.getDenseRow(0) == buffer);
+    CHECK(g3.getGraph() == (g1 * -2).getGraph());
+    CHECK(g3.isGraphNegWeighted());
+    g3 /= -2;
+    CHECK(g3.haveSameEdges(g1));
+    CHECK_FALSE(g3.isGraphNegWeighted());
+    g3 += g3;
+    CHECK(g3.getGraph() == (g1 * 2).getGraph());
+    g3 *= g2;
+    CHECK(g3.getGraph() == (g1 * 2 * g2).getGraph());
+    CHECK_THROWS_AS(g3 /= 0, std::invalid_argument);
+
+    // Division rounds toward zero and drops edges that reach zero
+    Graph g4 = g2;
+    g4 /= 2;
+    CHECK(g4.getGraph() == vector<vector<int>>({{0, 1, 1}, {1, 0, 0}, {1, 0, 0}}));
+    g4.toSparse();
+    g4 /= 2;
+    CHECK(g4.getNumberOfEdges() == 0);
+
+    // Temporaries lend their storage to the result
+    Graph g5;
+    g5.loadGraph(graph1);
+    buffer = g5.getDenseRow(0);
+    Graph g6 = std::move(g5) + g2;
+    CHECK(g6.getDenseRow(0) == buffer);
+    CHECK(g6.getGraph() == (g1 + g2).getGraph());
+    Graph g7 = -(g1 + g2) * 3 - g2;
+    CHECK(g7.getGraph() == (g1 * -3 - g2 * 4).getGraph());
+
+    // Mixed backends follow the binary operators
+    Graph sparse = g2;
+    sparse.toSparse();
+    Graph g8 = sparse;
+    g8 += g1;
+    CHECK(!g8.isSparse());
+    CHECK(g8.getGraph() == (g1 + g2).getGraph());
+    g8 = sparse;
+    g8 += sparse;
+    CHECK(g8.isSparse());
+    CHECK(g8.getGraph() == (g2 * 2).getGraph());
+
+    Graph g9;
+    g9.loadGraph({{0, 1}, {1, 0}});
+    CHECK_THROWS_AS(g1 += g9, std::invalid_argument);
+    CHECK_THROWS_AS(g1 -= g9, std::invalid_argument);
+}
+
+TEST_CASE("Test copy-on-write sharing") {
+    Graph g1;
+    vector<vector<int>> graph = {
+            {0, 1, 0},
+            {1, 0, 1},
+            {0, 1, 0}
+    };
+    g1.loadGraph(graph);
+
+    // Copies share the matrix until one of them changes
+    Graph g2 = g1;
+    Graph g3;
+    g3 = g1;
+    CHECK(g2.getDenseRow(0) == g1.getDenseRow(0));
+    CHECK(g3.getDenseRow(0) == g1.getDenseRow(0));
+    CHECK(g2.getNumberOfEdges() == 2);
+
+    ++g2;
+    CHECK(g2.getDenseRow(0) != g1.getDenseRow(0));
+    CHECK(g2.getWeight(0, 1) == 2);
+    CHECK(g1.getWeight(0, 1) == 1);
+    CHECK(g3.getDenseRow(0) == g1.getDenseRow(0));
+    CHECK(g1.getGraph() == graph);
+
+    // Postfix operators return the shared old value
+    Graph g4 = g3++;
+    CHECK(g4.getDenseRow(0) == g1.getDenseRow(0));
+    CHECK(g4.getGraph() == graph);
+    CHECK(g3.getWeight(1, 2) == 2);
+
+    // Every kind of write detaches, including conversions and reloads
+    Graph g5 = g1;
+    g5.toSparse();
+    CHECK(!g1.isSparse());
+    CHECK(g5.haveSameEdges(g1));
+    Graph g6 = g5;
+    g6 *= 3;
+    CHECK(g5.getWeight(0, 1) == 1);
+    CHECK(g6.getWeight(0, 1) == 3);
+    Graph g7 = g1;
+    g7 += g1;
+    g7.loadGraph({{0, 5}, {5, 0}});
+    CHECK(g1.getGraph() == graph);
+    CHECK(g7.getVertexNum() == 2);
+
+    // A moved-from graph is empty but usable
+    Graph g8 = g1;
+    Graph g9 = std::move(g8);
+    CHECK(g9.getGraph() == graph);
+    CHECK(g8.getVertexNum() == 0);
+    g8.loadGraph(graph);
+    CHECK(g8 == g9);
+}
+
+TEST_CASE("Test iterative depth-first search") {
+    // A 300000-vertex path used to overflow the call stack
+    const int size = 300000;
+    vector<int> offsets(1, 0), targets, weights;
+    for (int i = 0; i < size; ++i) {
+        if (i > 0) {
+            targets.push_back(i - 1);
+            weights.push_back(1);
+        }
+        if (i + 1 < size) {
+            targets.push_back(i + 1);
+            weights.push_back(1);
+        }
+        offsets.push_back(static_cast<int>(targets.size()));
+    }
+    Graph path;
+    path.loadSparseGraph(size, offsets, targets, weights);
+    CHECK(Algorithms::isConnected(path) == 1);
+    std::ostringstream silent;
+    CHECK(Algorithms::isContainsCycle(path, silent) == "0");
+
+    // One-way chain whose last vertex loops back three steps: the cycle sits at the bottom of the search
+    vector<int> chainOffsets(1, 0), chainTargets, chainWeights;
+    for (int i = 0; i < size; ++i) {
+        chainTargets.push_back(i + 1 < size ? i + 1 : size - 3);
+        chainWeights.push_back(1);
+        chainOffsets.push_back(i + 1);
+    }
+    Graph chain;
+    chain.loadSparseGraph(size, chainOffsets, chainTargets, chainWeights);
+    CHECK(Algorithms::isConnected(chain) == 0);
+    CHECK(Algorithms::isContainsCycle(chain, silent) == "");
+
+    // The engine reports discovery and finishing order through a visitor
+    struct OrderRecorder : DFSVisitor {
+        vector<int> discovered, finished;
+        int backEdges = 0;
+        bool discover(int v) {
+            discovered.push_back(v);
+            return false;
+        }
+        bool backEdge(int, int, int) {
+            ++backEdges;
+            return false;
+        }
+        bool finish(int v) {
+            finished.push_back(v);
+            return false;
+        }
+    };
+    Graph g1;
+    vector<vector<int>> graph = {
+            {0, 1, 1, 0},
+            {0, 0, 1, 0},
+            {1, 0, 0, 0},
+            {0, 0, 0, 0}
+    };
+    g1.loadGraph(graph);
+    DepthFirstSearch search(g1);
+    OrderRecorder recorder;
+    CHECK_FALSE(search.runAll(recorder));
+    CHECK(recorder.discovered == vector<int>({0, 1, 2, 3}));
+    CHECK(recorder.finished == vector<int>({2, 1, 0, 3}));
+    CHECK(recorder.backEdges == 1);
+    CHECK(search.getParents() == vector<int>({-1, 0, 1, -1}));
+}
+
+TEST_CASE("Test strongly connected components") {
+    // {0, 1, 2} and {3, 4} are cycles, 5 stands alone: 0..2 -> 3..4 -> 5
+    Graph g1;
+    vector<vector<int>> graph = {
+            {0, 1, 0, 0, 0, 0},
+            {0, 0, 1, 0, 0, 0},
+            {1, 0, 0, 1, 0, 0},
+            {0, 0, 0, 0, 1, 0},
+            {0, 0, 0, 1, 0, 1},
+            {0, 0, 0, 0, 0, 0}
+    };
+    g1.loadGraph(graph);
+    Algorithms::StrongComponents scc = Algorithms::stronglyConnectedComponents(g1);
+    CHECK(scc.count == 3);
+    CHECK(scc.component == vector<int>({0, 0, 0, 1, 1, 2}));
+    CHECK(scc.sizes == vector<int>({3, 2, 1}));
+    CHECK(scc.condensation.getGraph() == vector<vector<int>>({{0, 1, 0}, {0, 0, 1}, {0, 0, 0}}));
+    CHECK(Algorithms::isConnected(g1) == 0);
+
+    // Closing 5 -> 0 merges everything
+    graph[5][0] = 1;
+    g1.loadGraph(graph);
+    scc = Algorithms::stronglyConnectedComponents(g1);
+    CHECK(scc.count == 1);
+    CHECK(scc.condensation.getNumberOfEdges() == 0);
+    CHECK(Algorithms::isConnected(g1) == 1);
+
+    // A million-vertex directed ring is one component, found without a transpose
+    const int size = 1000000;
+    vector<int> offsets(size + 1), targets(size), weights(size, 1);
+    for (int i = 0; i < size; ++i) {
+        offsets[i + 1] = i + 1;
+        targets[i] = (i + 1) % size;
+    }
+    Graph ring;
+    ring.loadSparseGraph(size, offsets, targets, weights);
+    CHECK(Algorithms::isConnected(ring) == 1);
+    targets[size - 1] = size - 1;
+    ring.loadSparseGraph(size, offsets, targets, weights);
+    scc = Algorithms::stronglyConnectedComponents(ring);
+    CHECK(scc.count == size);
+    CHECK(scc.component[0] == 0);
+    CHECK(scc.component[size - 1] == size - 1);
+}
+
+TEST_CASE("Test direction-optimizing BFS") {
+    // Hubs make the middle levels cover most vertices, so the search switches to bottom-up
+    const int size = 4000;
+    for (int directed = 0; directed < 2; ++directed) {
+        vector<vector<int>> adjacency(size);
+        for (int v = 1; v < size; ++v) {
+            int hub = v % 7 == 0 ? 0 : (v * 31) % (v < 50 ? v : 50);
+            adjacency[v].push_back(hub);
+            adjacency[directed ? v : hub].push_back(directed ? (v * 17) % size : v);
+            if (!directed) {
+                adjacency[v].push_back((v * 13) % size);
+                adjacency[(v * 13) % size].push_back(v);
+            }
+        }
+        vector<int> offsets(1, 0), targets, weights;
+        for (int v = 0; v < size; ++v) {
+            std::sort(adjacency[v].begin(), adjacency[v].end());
+            adjacency[v].erase(std::unique(adjacency[v].begin(), adjacency[v].end()), adjacency[v].end());
+            for (int u : adjacency[v]) {
+                targets.push_back(u);
+                weights.push_back(1);
+            }
+            offsets.push_back(static_cast<int>(targets.size()));
+        }
+        Graph g1;
+        g1.loadSparseGraph(size, offsets, targets, weights);
+        CHECK(g1.isGraphDirected() == (directed == 1));
+
+        // Plain queue-based BFS distances from vertex 1 as the reference
+        vector<int> expected(size, -1);
+        vector<int> queue(1, 1);
+        expected[1] = 0;
+        for (size_t head = 0; head < queue.size(); ++head) {
+            for (int u : adjacency[queue[head]]) {
+                if (expected[u] == -1) {
+                    expected[u] = expected[queue[head]] + 1;
+                    queue.push_back(u);
+                }
+            }
+        }
+        bool allMatch = true;
+        for (int end = 0; end < size; end += 97) {
+            std::pair<int, vector<int>> result = Algorithms::bfsShortestPath(g1, 1, end);
+            allMatch = allMatch && result.first == expected[end];
+            if (result.first > 0) {
+                allMatch = allMatch && static_cast<int>(result.second.size()) == result.first + 1;
+                for (size_t i = 0; i + 1 < result.second.size(); ++i) {
+                    allMatch = allMatch && g1.getWeight(result.second[i], result.second[i + 1]) == 1;
+                }
+            }
+        }
+        CHECK(allMatch);
+    }
+}
+
+TEST_CASE("Test Dijkstra priority queues") {
+    // Both queues pop in key order and lower the key of a queued vertex in place
+    IndexedDaryHeap<4> dary(6);
+    RadixHeap radix(6);
+    int keys[] = {50, 7, 7, 1000, 3, 64};
+    for (int v = 0; v < 6; ++v) {
+        dary.update(v, keys[v]);
+        radix.update(v, keys[v]);
+    }
+    dary.update(3, 5);
+    radix.update(3, 5);
+    dary.update(1, 9);
+    radix.update(1, 9);
+    CHECK(dary.contains(3));
+    CHECK(dary.minKey() == 3);
+    vector<int> daryOrder, radixOrder;
+    while (!dary.empty()) {
+        daryOrder.push_back(dary.pop());
+    }
+    while (!radix.empty()) {
+        radixOrder.push_back(radix.pop());
+    }
+    CHECK(daryOrder[0] == 4);
+    CHECK(daryOrder[1] == 3);
+    CHECK(daryOrder[4] == 0);
+    CHECK(daryOrder[5] == 5);
+    CHECK(radixOrder[0] == 4);
+    CHECK(radixOrder[1] == 3);
+    CHECK(radixOrder[4] == 0);
+    CHECK(radixOrder[5] == 5);
+    CHECK_FALSE(radix.contains(3));
+
+    // A weighted grid with pseudo-random weights, checked against Bellman-Ford relaxation
+    const int side = 40, size = side * side;
+    vector<int> offsets(1, 0), targets, weights;
+    for (int v = 0; v < size; ++v) {
+        int row = v / side, col = v % side;
+        int candidates[] = {v - side, v - 1, v + 1, v + side};
+        bool valid[] = {row > 0, col > 0, col + 1 < side, row + 1 < side};
+        for (int c = 0; c < 4; ++c) {
+            if (valid[c]) {
+                targets.push_back(candidates[c]);
+                weights.push_back(1 + (v * 7 + candidates[c] * 13) % 97);
+            }
+        }
+        offsets.push_back(static_cast<int>(targets.size()));
+    }
+    Graph g1;
+    g1.loadSparseGraph(size, offsets, targets, weights);
+    vector<int> expected(size, std::numeric_limits<int>::max());
+    expected[5] = 0;
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (int v = 0; v < size; ++v) {
+            for (int e = offsets[v]; e < offsets[v + 1] && expected[v] != std::numeric_limits<int>::max(); ++e) {
+                if (expected[v] + weights[e] < expected[targets[e]]) {
+                    expected[targets[e]] = expected[v] + weights[e];
+                    changed = true;
+                }
+            }
+        }
+    }
+    bool allMatch = true;
+    for (int end = 0; end < size; end += 37) {
+        std::pair<int, vector<int>> daryResult = Algorithms::dijkstraShortestPath(g1, 5, end);
+        std::pair<int, vector<int>> radixResult = Algorithms::dijkstraShortestPath(g1, 5, end, Algorithms::DijkstraQueue::RadixHeap);
+        allMatch = allMatch && daryResult.first == expected[end] && radixResult.first == expected[end];
+        int length = 0;
+        for (size_t i = 0; i + 1 < radixResult.second.size(); ++i) {
+            length += g1.getWeight(radixResult.second[i], radixResult.second[i + 1]);
+        }
+        allMatch = allMatch && length == expected[end] && radixResult.second.back() == end;
+    }
+    CHECK(allMatch);
+
+    Graph g2;
+    g2.loadGraph({
+        {0, -1},
+        {-1, 0}});
+    CHECK_THROWS_AS(Algorithms::dijkstraShortestPath(g2, 0, 1, Algorithms::DijkstraQueue::RadixHeap), std::invalid_argument);
+}
+
+TEST_CASE("Test queue-based Bellman-Ford") {
+    // A long chain with negative shortcuts and positive back arcs: no negative cycle
+    const int size = 3000;
+    vector<vector<int>> arcs(size);   // target, weight pairs
+    for (int v = 0; v + 1 < size; ++v) {
+        arcs[v].push_back(v + 1);
+        arcs[v].push_back(5);
+        if (v % 100 == 0 && v + 7 < size) {
+            arcs[v].push_back(v + 7);
+            arcs[v].push_back(-2);
+        }
+        if (v >= 10) {
+            arcs[v].push_back(v - 10);
+            arcs[v].push_back(60);
+        }
+    }
+    vector<int> offsets(1, 0), targets, weights;
+    for (int v = 0; v < size; ++v) {
+        vector<std::pair<int, int>> row;
+        for (size_t i = 0; i < arcs[v].size(); i += 2) {
+            row.push_back(std::make_pair(arcs[v][i], arcs[v][i + 1]));
+        }
+        std::sort(row.begin(), row.end());
+        for (const std::pair<int, int>& arc : row) {
+            targets.push_back(arc.first);
+            weights.push_back(arc.second);
+        }
+        offsets.push_back(static_cast<int>(targets.size()));
+    }
+    Graph g1;
+    g1.loadSparseGraph(size, offsets, targets, weights);
+
+    const int INF = std::numeric_limits<int>::max();
+    vector<int> expected(size, INF);
+    expected[0] = 0;
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (int v = 0; v < size; ++v) {
+            for (int e = offsets[v]; e < offsets[v + 1] && expected[v] != INF; ++e) {
+                if (expected[v] + weights[e] < expected[targets[e]]) {
+                    expected[targets[e]] = expected[v] + weights[e];
+                    changed = true;
+                }
+            }
+        }
+    }
+    vector<int> dist(size, INF), parent(size, -1);
+    dist[0] = 0;
+    CHECK_FALSE(Algorithms::relaxEdges(g1, dist, parent));
+    CHECK(dist == expected);
+    CHECK(parent[7] == 0);
+    CHECK(Algorithms::shortestPath(g1, 0, 9) == "0->7->8->9");
+
+    // Closing a negative cycle deep in the chain
+    vector<int> cycleTargets, cycleWeights, cycleOffsets(1, 0);
+    for (int v = 0; v < size; ++v) {
+        for (int e = offsets[v]; e < offsets[v + 1]; ++e) {
+            cycleTargets.push_back(targets[e]);
+            cycleWeights.push_back(v == 2510 && targets[e] == 2500 ? -100 : weights[e]);
+        }
+        cycleOffsets.push_back(static_cast<int>(cycleTargets.size()));
+    }
+    Graph g2;
+    g2.loadSparseGraph(size, cycleOffsets, cycleTargets, cycleWeights);
+    std::fill(dist.begin(), dist.end(), INF);
+    std::fill(parent.begin(), parent.end(), -1);
+    dist[0] = 0;
+    CHECK(Algorithms::relaxEdges(g2, dist, parent));
+    CHECK(Algorithms::shortestPath(g2, 0, 9) == "Negative cycle detected");
+
+    // negativeCycle prints the cycle; its weights must add up to less than zero
+    std::stringstream captured;
+    Algorithms::negativeCycle(g2, captured);
+    std::string label;
+    captured >> label >> label >> label;
+    CHECK(label == "found:");
+    vector<int> cycle;
+    for (int v; captured >> v;) {
+        cycle.push_back(v);
+    }
+    REQUIRE(cycle.size() >= 3);
+    CHECK(cycle.front() == cycle.back());
+    long long total = 0;
+    bool allEdges = true;
+    for (size_t i = 0; i + 1 < cycle.size(); ++i) {
+        allEdges = allEdges && g2.getWeight(cycle[i], cycle[i + 1]) != 0;
+        total += g2.getWeight(cycle[i], cycle[i + 1]);
+    }
+    CHECK(allEdges);
+    CHECK(total < 0);
+}
+
+TEST_CASE("Test batch shortest-path trees") {
+    // Weighted: one tree answers every target the single-pair search does
+    Graph g1;
+    g1.loadGraph({
+        {0, 4, 1, 0, 0},
+        {4, 0, 2, 5, 0},
+        {1, 2, 0, 8, 0},
+        {0, 5, 8, 0, 0},
+        {0, 0, 0, 0, 0}});
+    Algorithms::ShortestPathTree tree = Algorithms::shortestPathTree(g1, 0);
+    CHECK(tree.source == 0);
+    CHECK_FALSE(tree.negativeCycle);
+    for (int v = 0; v < 4; ++v) {
+        std::pair<int, vector<int>> single = Algorithms::dijkstraShortestPath(g1, 0, v);
+        CHECK(tree.distance[v] == single.first);
+        CHECK(tree.pathTo(v) == single.second);
+    }
+    CHECK(tree.pathTo(3) == vector<int>({0, 2, 1, 3}));
+    CHECK_FALSE(tree.reaches(4));
+    CHECK(tree.pathTo(4).empty());
+    CHECK(tree.distance[4] == std::numeric_limits<int>::max());
+
+    // Targets stop the search early, but their own entries are final
+    Algorithms::ShortestPathTree partial = Algorithms::shortestPathTree(g1, 3, {1});
+    CHECK(partial.distance[1] == 5);
+    CHECK(partial.pathTo(1) == vector<int>({3, 1}));
+
+    // Unweighted and negative-weighted graphs use BFS and Bellman-Ford
+    Graph g2;
+    g2.loadGraph({
+        {0, 1, 0, 0},
+        {0, 0, 1, 0},
+        {0, 0, 0, 1},
+        {0, 0, 0, 0}});
+    CHECK(Algorithms::shortestPathTree(g2, 0).distance == vector<int>({0, 1, 2, 3}));
+    CHECK_FALSE(Algorithms::shortestPathTree(g2, 2).reaches(0));
+    Graph g3;
+    g3.loadGraph({
+        {0, 4, 1, 0},
+        {0, 0, 0, 1},
+        {0, -2, 0, 0},
+        {0, 0, 0, 0}});
+    Algorithms::ShortestPathTree signedTree = Algorithms::shortestPathTree(g3, 0, {3});
+    CHECK(signedTree.distance[3] == 0);
+    CHECK(signedTree.pathTo(3) == vector<int>({0, 2, 1, 3}));
+    Graph g4;
+    g4.loadGraph({
+        {0, 1, 0},
+        {0, 0, -3},
+        {0, 1, 0}});
+    CHECK(Algorithms::shortestPathTree(g4, 0).negativeCycle);
+
+    // Many-to-many on a grid, in parallel, matches one tree per source
+    const int side = 60, size = side * side;
+    vector<int> offsets(1, 0), targets, weights;
+    for (int v = 0; v < size; ++v) {
+        int row = v / side, col = v % side;
+        int candidates[] = {v - side, v - 1, v + 1, v + side};
+        bool valid[] = {row > 0, col > 0, col + 1 < side, row + 1 < side};
+        for (int c = 0; c < 4; ++c) {
+            if (valid[c]) {
+                targets.push_back(candidates[c]);
+                weights.push_back(1 + (v + candidates[c]) % 9);
+            }
+        }
+        offsets.push_back(static_cast<int>(targets.size()));
+    }
+    Graph g5;
+    g5.loadSparseGraph(size, offsets, targets, weights);
+    vector<int> sources = {0, 1234, 3599, 1800, 59};
+    vector<int> deliveries = {17, 900, 2500, 3599, 0};
+    ThreadPool& pool = ThreadPool::shared();
+    int threads = pool.getThreadCount();
+    long long minWork = pool.getMinParallelWork();
+    pool.setThreadCount(4);
+    pool.setMinParallelWork(1);
+    vector<Algorithms::ShortestPathTree> trees = Algorithms::shortestPathTrees(g5, sources, deliveries);
+    pool.setThreadCount(threads);
+    pool.setMinParallelWork(minWork);
+    REQUIRE(trees.size() == sources.size());
+    bool allMatch = true;
+    for (size_t i = 0; i < sources.size(); ++i) {
+        Algorithms::ShortestPathTree whole = Algorithms::shortestPathTree(g5, sources[i]);
+        allMatch = allMatch && trees[i].source == sources[i];
+        for (int target : deliveries) {
+            allMatch = allMatch && trees[i].distance[target] == whole.distance[target];
+            allMatch = allMatch && trees[i].pathTo(target).front() == sources[i] && trees[i].pathTo(target).back() == target;
+        }
+    }
+    CHECK(allMatch);
+
+    CHECK_THROWS_AS(Algorithms::shortestPathTree(g1, 5), std::invalid_argument);
+    CHECK_THROWS_AS(Algorithms::shortestPathTrees(g1, {0}, {-1}), std::invalid_argument);
+}
+
+TEST_CASE("Test all-pairs shortest paths") {
+    // Directed graph spanning several tiles. Weights are positive ones shifted by
+    // vertex potentials, so some are negative but every cycle stays positive.
+    const int size = 300;
+    vector<vector<int>> matrix(size, vector<int>(size, 0));
+    for (int u = 0; u < size; ++u) {
+        for (int v = 0; v < size; ++v) {
+            if (u != v && (u * 131 + v * 71) % 23 < 2) {
+                matrix[u][v] = 1 + (u + v) % 17 + (u * 37) % 11 - (v * 37) % 11;
+            }
+        }
+    }
+    matrix[5][7] = 0;
+    for (int v = 0; v < size; ++v) {
+        matrix[10][v] = 0;
+        matrix[v][10] = 0;
+    }
+    Graph g1;
+    g1.loadGraph(matrix);
+
+    ThreadPool& pool = ThreadPool::shared();
+    int threads = pool.getThreadCount();
+    long long minWork = pool.getMinParallelWork();
+    pool.setThreadCount(4);
+    pool.setMinParallelWork(1);
+    Algorithms::AllPairsPaths blocked = Algorithms::allPairsShortestPaths(g1);
+    Algorithms::AllPairsPaths minPlus = Algorithms::allPairsShortestPaths(g1, Algorithms::AllPairsMethod::MinPlus);
+    pool.setThreadCount(threads);
+    pool.setMinParallelWork(minWork);
+
+    CHECK_FALSE(blocked.negativeCycle);
+    CHECK_FALSE(minPlus.negativeCycle);
+    CHECK(blocked.distance == minPlus.distance);
+    bool allMatch = true;
+    for (int source = 0; source < size; source += 13) {
+        Algorithms::ShortestPathTree tree = Algorithms::shortestPathTree(g1, source);
+        for (int v = 0; v < size; ++v) {
+            allMatch = allMatch && blocked.getDistance(source, v) == tree.distance[v];
+            vector<int> hops = minPlus.path(source, v);
+            if (tree.reaches(v)) {
+                int length = 0;
+                for (size_t i = 0; i + 1 < hops.size(); ++i) {
+                    allMatch = allMatch && g1.getWeight(hops[i], hops[i + 1]) != 0;
+                    length += g1.getWeight(hops[i], hops[i + 1]);
+                }
+                allMatch = allMatch && hops.front() == source && hops.back() == v && length == tree.distance[v];
+            } else {
+                allMatch = allMatch && hops.empty();
+            }
+        }
+    }
+    CHECK(allMatch);
+    CHECK(blocked.path(3, 3) == vector<int>({3}));
+    CHECK(blocked.getDistance(0, 10) == std::numeric_limits<int>::max());
+    CHECK(blocked.path(10, 0).empty());
+
+    Graph g2;
+    g2.loadGraph({
+        {0, 2, 0, 0},
+        {0, 0, 1, 0},
+        {-4, 0, 0, 0},
+        {0, 0, 0, 0}});
+    CHECK(Algorithms::allPairsShortestPaths(g2).negativeCycle);
+    CHECK(Algorithms::allPairsShortestPaths(g2, Algorithms::AllPairsMethod::MinPlus).negativeCycle);
+}
+
+TEST_CASE("Test parallel breadth-first search") {
+    // Paths, connectivity and partitions must not depend on the thread count
+    const int size = 6000;
+    vector<int> offsets(1, 0), targets, weights;
+    vector<vector<int>> adjacency(size);
+    for (int v = 1; v < size; ++v) {
+        int hub = v % 5 == 0 ? 0 : (v * 7) % (v < 40 ? v : 40);
+        int far = (v * 29) % size;
+        for (int u : {hub, far}) {
+            if (u != v && (u + v) % 2 == 1) {
+                adjacency[v].push_back(u);
+                adjacency[u].push_back(v);
+            }
+        }
+    }
+    for (int v = 0; v < size; ++v) {
+        std::sort(adjacency[v].begin(), adjacency[v].end());
+        adjacency[v].erase(std::unique(adjacency[v].begin(), adjacency[v].end()), adjacency[v].end());
+        for (int u : adjacency[v]) {
+            targets.push_back(u);
+            weights.push_back(1);
+        }
+        offsets.push_back(static_cast<int>(targets.size()));
+    }
+    Graph g1;
+    g1.loadSparseGraph(size, offsets, targets, weights);
+    Graph g2 = g1;
+    g2.toBitPacked();
+    // Directed: keep only the edges going up
+    vector<int> upOffsets(1, 0), upTargets, upWeights;
+    for (int v = 0; v < size; ++v) {
+        for (int u : adjacency[v]) {
+            if (u > v || v % 3 == 0) {
+                upTargets.push_back(u);
+                upWeights.push_back(1);
+            }
+        }
+        upOffsets.push_back(static_cast<int>(upTargets.size()));
+    }
+    Graph g3;
+    g3.loadSparseGraph(size, upOffsets, upTargets, upWeights);
+
+    ThreadPool& pool = ThreadPool::shared();
+    int threads = pool.getThreadCount();
+    long long minWork = pool.getMinParallelWork();
+    vector<std::string> results[2];
+    for (int run = 0; run < 2; ++run) {
+        pool.setThreadCount(run == 0 ? 1 : 4);
+        pool.setMinParallelWork(run == 0 ? minWork : 1);
+        for (const Graph* graph : {&g1, &g2, &g3}) {
+            for (int end = 1; end < size; end += 241) {
+                results[run].push_back(Algorithms::shortestPath(*graph, 3, end));
+            }
+            results[run].push_back(Algorithms::isBipartite(*graph));
+            results[run].push_back(std::to_string(Algorithms::isConnected(*graph)));
+            Algorithms::ShortestPathTree tree = Algorithms::shortestPathTree(*graph, 1);
+            for (int v = 0; v < size; v += 7) {
+                results[run].push_back(std::to_string(tree.parent[v]));
+            }
+        }
+    }
+    pool.setThreadCount(threads);
+    pool.setMinParallelWork(minWork);
+    CHECK(results[0] == results[1]);
+    CHECK(results[0][25].substr(0, 23) == "The graph is bipartite.");
+}
+
+TEST_CASE("Test delta-stepping shortest paths") {
+    // Directed grid with light and heavy edges; the last row is unreachable
+    const int side = 50, size = side * side;
+    vector<int> offsets(1, 0), targets, weights;
+    for (int v = 0; v < size; ++v) {
+        int row = v / side, col = v % side;
+        int candidates[] = {v - side, v - 1, v + 1, v + side};
+        bool valid[] = {row > 0 && row < side - 1, col > 0, col + 1 < side, row + 2 < side};
+        for (int c = 0; c < 4; ++c) {
+            if (valid[c] && row < side - 1) {
+                targets.push_back(candidates[c]);
+                weights.push_back(c == 2 && v % 7 == 0 ? 300 : 1 + (v * 3 + c * 11) % 40);
+            }
+        }
+        offsets.push_back(static_cast<int>(targets.size()));
+    }
+    Graph g1;
+    g1.loadSparseGraph(size, offsets, targets, weights);
+
+    ThreadPool& pool = ThreadPool::shared();
+    int threads = pool.getThreadCount();
+    long long minWork = pool.getMinParallelWork();
+    vector<vector<int>> paths[2];
+    bool allMatch = true;
+    for (int run = 0; run < 2; ++run) {
+        pool.setThreadCount(run == 0 ? 1 : 4);
+        pool.setMinParallelWork(run == 0 ? minWork : 1);
+        for (int delta : {0, 1, 17, 1000}) {
+            for (int end = 0; end < size; end += 53) {
+                std::pair<int, vector<int>> expected = Algorithms::dijkstraShortestPath(g1, 60, end);
+                std::pair<int, vector<int>> result = Algorithms::deltaSteppingShortestPath(g1, 60, end, delta);
+                allMatch = allMatch && result.first == expected.first;
+                int length = 0;
+                for (size_t i = 0; i + 1 < result.second.size(); ++i) {
+                    length += g1.getWeight(result.second[i], result.second[i + 1]);
+                }
+                allMatch = allMatch && (result.first == -1 ? result.second.empty() : length == result.first);
+                paths[run].push_back(result.second);
+            }
+        }
+    }
+    pool.setThreadCount(threads);
+    pool.setMinParallelWork(minWork);
+    CHECK(allMatch);
+    CHECK(paths[0] == paths[1]);
+    CHECK(Algorithms::deltaSteppingShortestPath(g1, 60, size - 1).first == -1);
+
+    Graph g2;
+    g2.loadGraph({
+        {0, -1},
+        {-1, 0}});
+    CHECK_THROWS_AS(Algorithms::deltaSteppingShortestPath(g2, 0, 1), std::invalid_argument);
+}
+
+TEST_CASE("Test bidirectional and A* search") {
+    // Directed weighted grid; a few one-way shortcuts and an unreachable corner
+    const int side = 40, size = side * side;
+    vector<int> offsets(1, 0), targets, weights;
+    for (int v = 0; v < size; ++v) {
+        int row = v / side, col = v % side;
+        if (v != size - 1) {
+            if (row > 0) {
+                targets.push_back(v - side);
+                weights.push_back(2 + v % 17);
+            }
+            if (col > 0) {
+                targets.push_back(v - 1);
+                weights.push_back(2 + (v * 3) % 9);
+            }
+            if (col + 1 < side && v + 1 != size - 1) {
+                targets.push_back(v + 1);
+                weights.push_back(1 + (v * 7) % 13);
+            }
+            if (row + 1 < side && v + side != size - 1) {
+                targets.push_back(v + side);
+                weights.push_back(1 + (v * 5) % 11);
+            }
+        }
+        offsets.push_back(static_cast<int>(targets.size()));
+    }
+    Graph g1;
+    g1.loadSparseGraph(size, offsets, targets, weights);
+
+    // Incoming edges are the transpose of the outgoing ones
+    bool transposed = true;
+    for (int v = 0; v < size; v += 37) {
+        int pos = g1.inEdgeBegin(v), source, weight;
+        int previous = -1, count = 0;
+        while (g1.nextInEdge(v, pos, source, weight)) {
+            transposed = transposed && source > previous && g1.getWeight(source, v) == weight;
+            previous = source;
+            ++count;
+        }
+        for (int u = 0; u < size; ++u) {
+            count -= g1.getWeight(u, v) != 0 ? 1 : 0;
+        }
+        transposed = transposed && count == 0;
+    }
+    CHECK(transposed);
+
+    Algorithms::Landmarks landmarks = Algorithms::selectLandmarks(g1, 4);
+    CHECK(landmarks.vertices.size() == 4);
+    bool allMatch = true;
+    for (int start : {0, 41, 777}) {
+        for (int end = 0; end < size; end += 29) {
+            std::pair<int, vector<int>> expected = Algorithms::dijkstraShortestPath(g1, start, end);
+            std::pair<int, vector<int>> results[] = {
+                Algorithms::bidirectionalShortestPath(g1, start, end),
+                Algorithms::aStarShortestPath(g1, start, end, landmarks),
+                Algorithms::aStarShortestPath(g1, start, end, [](int) { return 0; })};
+            for (const std::pair<int, vector<int>>& result : results) {
+                allMatch = allMatch && result.first == expected.first;
+                allMatch = allMatch && (expected.first == -1 || landmarks.lowerBound(start, end) <= expected.first);
+                int length = 0;
+                for (size_t i = 0; i + 1 < result.second.size(); ++i) {
+                    length += g1.getWeight(result.second[i], result.second[i + 1]);
+                }
+                allMatch = allMatch && (result.first == -1 ? result.second.empty()
+                                        : length == result.first && result.second.front() == start && result.second.back() == end);
+            }
+        }
+    }
+    CHECK(allMatch);
+    CHECK(Algorithms::bidirectionalShortestPath(g1, 0, size - 1).first == -1);
+    CHECK(Algorithms::aStarShortestPath(g1, 5, 5, landmarks).second == vector<int>{5});
+
+    // Unweighted graphs meet in the middle level by level
+    vector<vector<int>> ring(12, vector<int>(12, 0));
+    for (int i = 0; i < 12; ++i) {
+        ring[i][(i + 1) % 12] = ring[(i + 1) % 12][i] = 1;
+    }
+    ring[0][6] = ring[6][0] = 0;
+    Graph g2;
+    g2.loadGraph(ring);
+    CHECK(Algorithms::bidirectionalShortestPath(g2, 0, 6).first == 6);
+    CHECK(Algorithms::bidirectionalShortestPath(g2, 1, 10) == Algorithms::bfsShortestPath(g2, 1, 10));
+    g2.toBitPacked();
+    CHECK(Algorithms::bidirectionalShortestPath(g2, 2, 7).first == 5);
+
+    Graph g3;
+    g3.loadGraph({
+        {0, -1},
+        {-1, 0}});
+    CHECK_THROWS_AS(Algorithms::bidirectionalShortestPath(g3, 0, 1), std::invalid_argument);
+    CHECK_THROWS_AS(Algorithms::selectLandmarks(g3, 1), std::invalid_argument);
+}
+
+TEST_CASE("Test structured results") {
+    Graph g1;
+    g1.loadGraph({
+        {0, 4, 1, 0, 0},
+        {4, 0, 2, 5, 0},
+        {1, 2, 0, 8, 0},
+        {0, 5, 8, 0, 0},
+        {0, 0, 0, 0, 0}});
+    vector<int> path;
+    path.reserve(16);
+    const int* buffer = path.data();
+    Algorithms::PathResult result = Algorithms::findShortestPath(g1, 0, 3, path);
+    CHECK(result.status == Algorithms::PathStatus::Found);
+    CHECK(result.distance == 8);
+    CHECK(path == vector<int>{0, 2, 1, 3});
+    CHECK(path.data() == buffer);
+    CHECK(Algorithms::formatPath(path) == Algorithms::shortestPath(g1, 0, 3));
+    CHECK(Algorithms::findShortestPath(g1, 0, 4, path).status == Algorithms::PathStatus::NoPath);
+    CHECK(path.empty());
+    CHECK(Algorithms::findShortestPath(g1, 0, 5, path).status == Algorithms::PathStatus::InvalidVertex);
+    CHECK(Algorithms::findShortestPath(g1, -1, 2, path).status == Algorithms::PathStatus::InvalidVertex);
+    CHECK(Algorithms::shortestPath(g1, 0, 5) == "-1");
+
+    Graph g2;
+    g2.loadGraph({
+        {0, 1, 0},
+        {0, 0, -3},
+        {1, 0, 0}});
+    CHECK(Algorithms::findShortestPath(g2, 0, 2, path).status == Algorithms::PathStatus::NegativeCycle);
+    CHECK(Algorithms::bellmanFordShortestPath(g2, 0, 2) == "Negative cycle detected");
+
+    // The cycle follows the edges and closes on its first vertex
+    vector<int> cycle;
+    CHECK(Algorithms::findCycle(g1, cycle));
+    CHECK(cycle.size() >= 4);
+    CHECK(cycle.front() == cycle.back());
+    bool follows = true;
+    for (size_t i = 0; i + 1 < cycle.size(); ++i) {
+        follows = follows && g1.getWeight(cycle[i], cycle[i + 1]) != 0;
+    }
+    CHECK(follows);
+    CHECK(Algorithms::findCycle(g2, cycle));
+    CHECK(cycle == vector<int>{0, 1, 2, 0});
+    Graph g3;
+    g3.loadGraph({
+        {0, 1, 0, 0},
+        {1, 0, 1, 0},
+        {0, 1, 0, 1},
+        {0, 0, 1, 0}});
+    CHECK_FALSE(Algorithms::findCycle(g3, cycle));
+    CHECK(cycle.empty());
+
+    // Sides as a bitmap: the path 0-1-2-3 alternates
+    vector<uint64_t> sides;
+    CHECK(Algorithms::bipartition(g3, sides));
+    CHECK(sides == vector<uint64_t>{0xA});
+    g3.toBitPacked();
+    CHECK(Algorithms::bipartition(g3, sides));
+    CHECK(sides == vector<uint64_t>{0xA});
+    CHECK_FALSE(Algorithms::bipartition(g1, sides));
+}
+
+// Counts the DFS events and collects every cycle instead of stopping at the first.
+struct CountingCycleVisitor : Algorithms::CycleVisitor {
+    int discovered = 0;
+    int examined = 0;
+    vector<vector<int>> cycles;
+
+    bool discover(int) {
+        ++discovered;
+        return false;
+    }
+    bool examineEdge(int, int, int) {
+        ++examined;
+        return false;
+    }
+    bool cycleFound(const vector<int>& cycle) {
+        cycles.push_back(cycle);
+        return false;
+    }
+};
+
+TEST_CASE("Test cycle visitors and quiet output") {
+    // Two directed triangles sharing vertex 0, and a tail 3 -> 5
+    Graph g1;
+    g1.loadGraph({
+        {0, 1, 0, 1, 0, 0},
+        {0, 0, 1, 0, 0, 0},
+        {1, 0, 0, 0, 0, 0},
+        {0, 0, 0, 0, 1, 1},
+        {1, 0, 0, 0, 0, 0},
+        {0, 0, 0, 0, 0, 0}});
+    vector<int> cycle;
+    CountingCycleVisitor visitor;
+    CHECK(Algorithms::findCycle(g1, cycle, visitor));
+    CHECK(visitor.discovered == 6);
+    CHECK(visitor.examined == g1.getNumberOfEdges());
+    CHECK(visitor.cycles == vector<vector<int>>{{0, 1, 2, 0}, {0, 3, 4, 0}});
+    CHECK(cycle == vector<int>{0, 3, 4, 0});
+
+    // Results go to the caller's stream, or nowhere
+    std::ostringstream out;
+    CHECK(Algorithms::isContainsCycle(g1, out) == "");
+    CHECK(out.str() == "The cycle is: 0 1 2 0 \n");
+
+    Graph g2;
+    g2.loadGraph({
+        {0, 2, 0},
+        {0, 0, -1},
+        {-3, 0, 0}});
+    CHECK(Algorithms::findNegativeCycle(g2, cycle));
+    CHECK(cycle.size() == 4);
+    CHECK(cycle.front() == cycle.back());
+    int total = 0;
+    for (size_t i = 0; i + 1 < cycle.size(); ++i) {
+        total += g2.getWeight(cycle[i], cycle[i + 1]);
+    }
+    CHECK(total == -2);
+    struct RecordingNegativeVisitor : Algorithms::NegativeCycleVisitor {
+        vector<vector<int>> cycles;
+        void negativeCycleFound(const vector<int>& found) { cycles.push_back(found); }
+    };
+    RecordingNegativeVisitor negativeVisitor;
+    vector<int> reported;
+    CHECK(Algorithms::findNegativeCycle(g2, reported, negativeVisitor));
+    CHECK(negativeVisitor.cycles == vector<vector<int>>{cycle});
+    std::ostringstream negative;
+    Algorithms::negativeCycle(g2, negative);
+    CHECK(negative.str().substr(0, 22) == "Negative cycle found: ");
+
+    Graph g3;
+    g3.loadGraph({
+        {0, -2},
+        {-2, 0}});
+    CHECK_FALSE(Algorithms::findNegativeCycle(g3, cycle));
+    CHECK(cycle.empty());
+    CHECK_FALSE(Algorithms::findNegativeCycle(g3, reported, negativeVisitor));
+    CHECK(negativeVisitor.cycles.size() == 1);
+    std::ostringstream none;
+    Algorithms::negativeCycle(g1, none);
+    CHECK(none.str() == "No negative cycle found.\n");
+
+    std::streambuf* old = cout.rdbuf(none.rdbuf());
+    Graph empty;
+    int connected = Algorithms::isConnected(empty);
+    cout.rdbuf(old);
+    CHECK(connected == 0);
+    CHECK(none.str() == "No negative cycle found.\n");
+}
+
+TEST_CASE("Test parallel connected components") {
+    // Random sparse graphs with many small components plus one large one;
+    // the reference labels come from a plain flood fill over both edge directions
+    ThreadPool& pool = ThreadPool::shared();
+    int threads = pool.getThreadCount();
+    long long minWork = pool.getMinParallelWork();
+    bool allMatch = true;
+    for (int directed = 0; directed < 2; ++directed) {
+        const int size = 3000;
+        vector<vector<int>> adjacency(size);
+        unsigned int seed = 17 + directed;
+        for (int i = 0; i < 2600; ++i) {
+            seed = seed * 1103515245 + 12345;
+            int u = (seed >> 8) % size;
+            seed = seed * 1103515245 + 12345;
+            int v = u < 2000 ? (seed >> 8) % 2000 : u + 1 + (seed >> 8) % 3;
+            if (v < size && u != v) {
+                adjacency[u].push_back(v);
+                if (!directed) {
+                    adjacency[v].push_back(u);
+                }
+            }
+        }
+        vector<int> offsets(1, 0), targets, weights;
+        for (vector<int>& row : adjacency) {
+            std::sort(row.begin(), row.end());
+            row.erase(std::unique(row.begin(), row.end()), row.end());
+            targets.insert(targets.end(), row.begin(), row.end());
+            weights.resize(targets.size(), 1);
+            offsets.push_back(static_cast<int>(targets.size()));
+        }
+        Graph g1;
+        g1.loadSparseGraph(size, offsets, targets, weights);
+
+        vector<vector<int>> both(adjacency);
+        for (int u = 0; u < size; ++u) {
+            for (int v : adjacency[u]) {
+                both[v].push_back(u);
+            }
+        }
+        vector<int> expected(size, -1);
+        int count = 0;
+        for (int start = 0; start < size; ++start) {
+            if (expected[start] != -1) {
+                continue;
+            }
+            vector<int> pending(1, start);
+            expected[start] = count;
+            while (!pending.empty()) {
+                int u = pending.back();
+                pending.pop_back();
+                for (int v : both[u]) {
+                    if (expected[v] == -1) {
+                        expected[v] = count;
+                        pending.push_back(v);
+                    }
+                }
+            }
+            ++count;
+        }
+
+        for (int run = 0; run < 3; ++run) {
+            pool.setThreadCount(run == 0 ? 1 : 4);
+            pool.setMinParallelWork(run == 0 ? minWork : 1);
+            if (run == 2 && !directed) {
+                g1.toBitPacked();
+            }
+            Algorithms::ConnectedComponents components = Algorithms::connectedComponents(g1);
+            allMatch = allMatch && components.component == expected && components.count == count;
+            int total = 0;
+            for (int c = 0; c < components.count; ++c) {
+                total += components.sizes[c];
+                allMatch = allMatch && components.sizes[c] == static_cast<int>(std::count(expected.begin(), expected.end(), c));
+            }
+            allMatch = allMatch && total == size;
+        }
+    }
+    pool.setThreadCount(threads);
+    pool.setMinParallelWork(minWork);
+    CHECK(allMatch);
+
+    Graph g2;
+    g2.loadGraph({
+        {0, 1, 0, 0},
+        {1, 0, 0, 0},
+        {0, 0, 0, 3},
+        {0, 0, 3, 0}});
+    Algorithms::ConnectedComponents components = Algorithms::connectedComponents(g2);
+    CHECK(components.count == 2);
+    CHECK(components.component == vector<int>{0, 0, 1, 1});
+    CHECK(components.sizes == vector<int>{2, 2});
+    CHECK(Algorithms::connectedComponents(Graph()).count == 0);
+}
+
+TEST_CASE("Test parallel bipartition with odd-cycle witness") {
+    // A large even grid, many small paths and 4-cycles, and optionally one
+    // triangle hidden among the small components
+    ThreadPool& pool = ThreadPool::shared();
+    int threads = pool.getThreadCount();
+    long long minWork = pool.getMinParallelWork();
+    bool allMatch = true, witnessValid = true;
+    for (int odd = 0; odd < 2; ++odd) {
+        const int side = 40, grid = side * side, size = grid + 3000;
+        vector<vector<int>> rows(size);
+        auto addEdge = [&](int u, int v) {
+            rows[u].push_back(v);
+            rows[v].push_back(u);
+        };
+        for (int v = 0; v < grid; ++v) {
+            if (v % side + 1 < side) {
+                addEdge(v, v + 1);
+            }
+            if (v + side < grid) {
+                addEdge(v, v + side);
+            }
+        }
+        for (int v = grid; v + 4 <= size; v += 4) {
+            addEdge(v, v + 1);
+            addEdge(v + 1, v + 2);
+            addEdge(v + 2, v + 3);
+            if ((v / 4) % 3 == 0) {
+                addEdge(v + 3, v);
+            }
+        }
+        if (odd) {
+            addEdge(grid + 2401, grid + 2403);
+        }
+        vector<int> offsets(1, 0), targets, weights;
+        for (vector<int>& row : rows) {
+            std::sort(row.begin(), row.end());
+            targets.insert(targets.end(), row.begin(), row.end());
+            offsets.push_back(static_cast<int>(targets.size()));
+        }
+        weights.assign(targets.size(), 1);
+        Graph g1;
+        g1.loadSparseGraph(size, offsets, targets, weights);
+
+        vector<uint64_t> sides[3];
+        vector<int> cycles[3];
+        bool bipartite[3];
+        for (int run = 0; run < 3; ++run) {
+            pool.setThreadCount(run == 0 ? 1 : 4);
+            pool.setMinParallelWork(run == 0 ? minWork : 1);
+            if (run == 2) {
+                g1.toBitPacked();
+            }
+            bipartite[run] = Algorithms::bipartition(g1, sides[run], cycles[run]);
+        }
+        allMatch = allMatch && bipartite[0] == !odd && bipartite[1] == bipartite[0] && bipartite[2] == bipartite[0];
+        allMatch = allMatch && sides[1] == sides[0] && sides[2] == sides[0];
+        allMatch = allMatch && cycles[1] == cycles[0] && cycles[2] == cycles[0];
+        allMatch = allMatch && cycles[0].empty() == !odd;
+        if (odd) {
+            const vector<int>& cycle = cycles[0];
+            witnessValid = cycle.size() % 2 == 0 && cycle.front() == cycle.back();
+            for (size_t i = 0; i + 1 < cycle.size(); ++i) {
+                witnessValid = witnessValid && g1.getWeight(cycle[i], cycle[i + 1]) != 0;
+            }
+        } else {
+            for (int u = 0; u < size; ++u) {
+                for (int v : rows[u]) {
+                    allMatch = allMatch && ((sides[0][u >> 6] >> (u & 63)) & 1) != ((sides[0][v >> 6] >> (v & 63)) & 1);
+                }
+            }
+        }
+    }
+    pool.setThreadCount(threads);
+    pool.setMinParallelWork(minWork);
+    CHECK(allMatch);
+    CHECK(witnessValid);
+
+    // A directed triangle: the witness follows the edges either way
+    Graph g2;
+    g2.loadGraph({
+        {0, 1, 0},
+        {0, 0, 1},
+        {1, 0, 0}});
+    vector<uint64_t> sides;
+    vector<int> cycle;
+    CHECK_FALSE(Algorithms::bipartition(g2, sides, cycle));
+    CHECK(cycle.size() == 4);
+    CHECK(cycle.front() == cycle.back());
+    Graph g3;
+    g3.loadGraph({
+        {1, 0},
+        {0, 0}});
+    CHECK_FALSE(Algorithms::bipartition(g3, sides, cycle));
+    CHECK(cycle == vector<int>{0, 0});
+}
+
+TEST_CASE("Test incremental connectivity") {
+    // Grow a sparse and a dense graph edge by edge; the index must agree with a
+    // fresh union-find labelling after every step
+    const int size = 60;
+    Graph grown[2];
+    vector<int> noEdges(size + 1, 0);
+    grown[0].loadSparseGraph(size, noEdges, vector<int>(), vector<int>());
+    grown[1].loadGraph(vector<vector<int>>(size, vector<int>(size, 0)));
+    CHECK(grown[0].getComponentCount() == size);
+    bool allMatch = true;
+    unsigned int seed = 5;
+    for (int step = 0; step < 80; ++step) {
+        seed = seed * 1103515245 + 12345;
+        int u = (seed >> 8) % size;
+        seed = seed * 1103515245 + 12345;
+        int v = (seed >> 8) % size;
+        vector<vector<int>> delta(size, vector<int>(size, 0));
+        delta[u][v] = delta[v][u] = 1 + step % 3;
+        Graph edge;
+        edge.loadGraph(delta);
+        for (int g = 0; g < 2; ++g) {
+            Graph before = grown[g];
+            if (g == 0) {
+                edge.toSparse();
+            }
+            grown[g] += edge;
+            Algorithms::ConnectedComponents expected = Algorithms::connectedComponents(grown[g]);
+            allMatch = allMatch && grown[g].getComponentCount() == expected.count;
+            allMatch = allMatch && Algorithms::isConnected(grown[g]) == (expected.count == 1 ? 1 : 0);
+            for (int w = 0; w < size; w += 7) {
+                allMatch = allMatch && grown[g].sameComponent(u, w) == (expected.component[u] == expected.component[w]);
+            }
+            // The copy taken before the step keeps its own answers
+            allMatch = allMatch && before.getComponentCount() == Algorithms::connectedComponents(before).count;
+        }
+    }
+    CHECK(allMatch);
+    CHECK(grown[0] == grown[1]);
+
+    // Cancelling an edge through += or removing edges with -= and -- rebuilds the index
+    Graph g1;
+    g1.loadGraph({
+        {0, 1, 0, 0},
+        {1, 0, 2, 0},
+        {0, 2, 0, 1},
+        {0, 0, 1, 0}});
+    CHECK(g1.getComponentCount() == 1);
+    CHECK(Algorithms::isConnected(g1) == 1);
+    Graph cut;
+    cut.loadGraph({
+        {0, 0, 0, 0},
+        {0, 0, -2, 0},
+        {0, -2, 0, 0},
+        {0, 0, 0, 0}});
+    g1 += cut;
+    CHECK(g1.getComponentCount() == 2);
+    CHECK_FALSE(g1.sameComponent(0, 3));
+    CHECK(g1.sameComponent(2, 3));
+    g1 -= cut;
+    CHECK(g1.getComponentCount() == 1);
+    --g1;
+    CHECK(g1.getComponentCount() == 3);
+    CHECK(g1.sameComponent(1, 2));
+    CHECK(Algorithms::isConnected(g1) == 0);
+
+    // Directed graphs: weakly connected for the index, strongly for isConnected
+    Graph g2;
+    g2.loadGraph({
+        {0, 1, 0},
+        {0, 0, 1},
+        {0, 0, 0}});
+    CHECK(g2.getComponentCount() == 1);
+    CHECK(Algorithms::isConnected(g2) == 0);
+    Graph back;
+    back.loadGraph({
+        {0, 0, 0},
+        {0, 0, 0},
+        {1, 0, 0}});
+    g2 += back;
+    CHECK(Algorithms::isConnected(g2) == 1);
+}
+
+TEST_CASE("Test nested parallel loops") {
+    ThreadPool& pool = ThreadPool::shared();
+    int threads = pool.getThreadCount();
+    long long minWork = pool.getMinParallelWork();
+    pool.setThreadCount(4);
+    pool.setMinParallelWork(1);
+
+    // A loop started from any range of another loop, the caller's included, runs serially
+    vector<int> hits(64, 0);
+    pool.parallelFor(0, 8, 1, [&](int from, int to) {
+        for (int i = from; i < to; ++i) {
+            pool.parallelFor(0, 8, 1, [&](int innerFrom, int innerTo) {
+                for (int j = innerFrom; j < innerTo; ++j) {
+                    ++hits[i * 8 + j];
+                }
+            });
+        }
+    });
+    CHECK(std::count(hits.begin(), hits.end(), 1) == 64);
+
+    // Loops of changing width reuse the same workers
+    long long total = 0;
+    for (int round = 0; round < 200; ++round) {
+        std::atomic<long long> sum(0);
+        pool.parallelFor(0, 2 + round % 3, 1, [&](int from, int to) {
+            for (int i = from; i < to; ++i) {
+                sum += i;
+            }
+        });
+        total += sum;
+    }
+    CHECK(total == 67 * 1 + 67 * 3 + 66 * 6);
+
+    // Parallel searches from several sources, each running a parallel breadth-first search
+    const int size = 100000;
+    vector<int> offsets(size + 1), targets, weights;
+    for (int v = 0; v < size; ++v) {
+        offsets[v] = static_cast<int>(targets.size());
+        if (v == 0) {
+            for (int u = 1; u < size; ++u) {
+                targets.push_back(u);
+                weights.push_back(1);
+            }
+        } else {
+            targets.push_back(0);
+            weights.push_back(1);
+        }
+    }
+    offsets[size] = static_cast<int>(targets.size());
+    Graph star;
+    star.loadSparseGraph(size, offsets, targets, weights);
+    vector<Algorithms::ShortestPathTree> trees = Algorithms::shortestPathTrees(star, {0, 1, 2, 3});
+    pool.setThreadCount(threads);
+    pool.setMinParallelWork(minWork);
+    REQUIRE(trees.size() == 4);
+    CHECK(trees[0].distance[size - 1] == 1);
+    CHECK(trees[3].distance[size - 1] == 2);
+    CHECK(trees[3].pathTo(size - 1) == vector<int>({3, 0, size - 1}));
+}
+
+TEST_CASE("Test queries on shared copies from several threads") {
+    Graph g1;
+    g1.loadGraph({
+        {0, 1, 0, 0},
+        {0, 0, 2, 0},
+        {0, 0, 0, 0},
+        {0, 0, 0, 0}});
+    vector<Graph> copies(4, g1);
+    vector<int> components(4), degrees(4), firstIn(4);
+    vector<int> viewsMatch(4);
+    vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            const Graph& copy = copies[t];
+            components[t] = copy.getComponentCount();
+            degrees[t] = copy.getDegree(1);
+            int pos = copy.inEdgeBegin(2), source = -1, weight;
+            copy.nextInEdge(2, pos, source, weight);
+            firstIn[t] = source;
+            viewsMatch[t] = copy.getGraph()[1][2] == 2 && copy.sameComponent(0, 2);
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    for (int t = 0; t < 4; ++t) {
+        CHECK(components[t] == 2);
+        CHECK(degrees[t] == 1);
+        CHECK(firstIn[t] == 1);
+        CHECK(viewsMatch[t]);
+    }
+
+    Graph moved = std::move(g1);
+    CHECK(g1.getVertexNum() == 0);
+    CHECK(g1.getComponentCount() == 0);
+    g1.loadGraph({{0, 1}, {1, 0}});
+    Graph other = std::move(moved);
+    CHECK(moved.getVertexNum() == 0);
+    CHECK(g1.getVertexNum() == 2);
+    CHECK(other.getVertexNum() == 4);
+}
+
+TEST_CASE("Test constructor flags that contradict the matrix") {
+    // A directed chain passed as undirected stays directed
+    Graph chain({{0, 1, 0}, {0, 0, 1}, {0, 0, 0}}, false, false, 3);
+    CHECK(chain.isGraphDirected());
+    CHECK(chain.getNumberOfEdges() == 2);
+    CHECK(Algorithms::isConnected(chain) == 0);
+    CHECK(chain.getComponentCount() == 1);
+
+    // A weighted triangle passed as unweighted still takes the cheaper route
+    Graph triangle({{0, 5, 1}, {5, 0, 1}, {1, 1, 0}}, false, false, 3);
+    CHECK(triangle.isGraphWeighted());
+    CHECK(Algorithms::shortestPath(triangle, 0, 1) == "0->2->1");
+
+    // Flags claiming direction and weights on a plain undirected path are ignored too
+    Graph path({{0, 1, 0}, {1, 0, 1}, {0, 1, 0}}, true, true, 3);
+    CHECK_FALSE(path.isGraphDirected());
+    CHECK_FALSE(path.isGraphWeighted());
+    CHECK(path.getNumberOfEdges() == 2);
+}
@@ -0,0 +1,244 @@
+// Nadav034@gmail.com
+
+#include "ThreadPool.hpp"
+#include <stdexcept>
+#include <exception>
+#include <algorithm>
+#include <atomic>
+using namespace std;
+
+// Set on pool workers, and on a caller while it drives a parallel loop, so that
+// nested parallel loops fall back to serial.
+static thread_local bool insideWorker = false;
+
+namespace {
+// Marks the calling thread as taking part in a parallel loop until the scope ends.
+struct DrivingLoop {
+    DrivingLoop() { insideWorker = true; }
+    ~DrivingLoop() { insideWorker = false; }
+};
+}
+
+/**
+ * Returns the pool shared by the whole program.
+ *
+ * @return The shared pool.
+ */
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+ThreadPool::ThreadPool() : stopping(false), threadCount(0), minParallelWork(1 << 16) {
+    unsigned hardware = thread::hardware_concurrency();
+    threadCount = hardware == 0 ? 1 : static_cast<int>(hardware);
+}
+
+ThreadPool::~ThreadPool() {
+    lock_guard<std::mutex> lock(resizeMutex);
+    resize(0);
+}
+
+/**
+ * Sets how many threads, including the caller, take part in a parallel loop.
+ *
+ * @param count The parallelism level; 1 runs everything serially and 0 uses every hardware thread.
+ * @throws std::invalid_argument if count is negative.
+ */
+void ThreadPool::setThreadCount(int count) {
+    if (count < 0) {
+        throw invalid_argument("Thread count cannot be negative.");
+    }
+    if (count == 0) {
+        unsigned hardware = thread::hardware_concurrency();
+        count = hardware == 0 ? 1 : static_cast<int>(hardware);
+    }
+    lock_guard<std::mutex> lock(queueMutex);
+    threadCount = count;
+}
+
+/**
+ * @return The number of threads taking part in a parallel loop.
+ */
+int ThreadPool::getThreadCount() const {
+    lock_guard<std::mutex> lock(queueMutex);
+    return threadCount;
+}
+
+/**
+ * Sets the least amount of work worth splitting across threads.
+ *
+ * @param work The threshold; smaller loops run on the calling thread.
+ */
+void ThreadPool::setMinParallelWork(long long work) {
+    lock_guard<std::mutex> lock(queueMutex);
+    minParallelWork = work;
+}
+
+/**
+ * @return The least amount of work split across threads.
+ */
+long long ThreadPool::getMinParallelWork() const {
+    lock_guard<std::mutex> lock(queueMutex);
+    return minParallelWork;
+}
+
+/**
+ * Starts or stops workers until workerCount of them are running. Tasks already
+ * queued are finished before the old workers exit. The caller holds resizeMutex.
+ *
+ * @param workerCount The number of background workers wanted.
+ */
+void ThreadPool::resize(int workerCount) {
+    if (static_cast<int>(workers.size()) == workerCount) {
+        return;
+    }
+    {
+        lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    taskReady.notify_all();
+    for (thread& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+    stopping = false;
+    for (int i = 0; i < workerCount; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+/**
+ * Body of every worker: runs queued tasks until the pool is resized or destroyed.
+ */
+void ThreadPool::workerLoop() {
+    insideWorker = true;
+    for (;;) {
+        function<void()> task;
+        {
+            unique_lock<std::mutex> lock(queueMutex);
+            taskReady.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (tasks.empty()) {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+/**
+ * Runs body over [begin, end), split into contiguous ranges processed concurrently.
+ *
+ * @param begin The first index.
+ * @param end One past the last index.
+ * @param workPerIndex The cost of one index, compared against the parallel threshold.
+ * @param body Called as body(rangeBegin, rangeEnd).
+ */
+void ThreadPool::parallelFor(int begin, int end, long long workPerIndex, const function<void(int, int)>& body) {
+    if (begin >= end) {
+        return;
+    }
+    int count;
+    {
+        lock_guard<std::mutex> lock(queueMutex);
+        count = threadCount;
+        if (static_cast<long long>(end - begin) * workPerIndex < minParallelWork) {
+            count = 1;
+        }
+    }
+    count = std::min(count, end - begin);
+    if (count <= 1 || insideWorker) {
+        body(begin, end);
+        return;
+    }
+
+    // The pool keeps threadCount - 1 workers; a narrower loop just queues fewer
+    // ranges. Workers are only restarted when the thread count changed.
+    {
+        lock_guard<std::mutex> resizing(resizeMutex);
+        int workerCount;
+        {
+            lock_guard<std::mutex> lock(queueMutex);
+            workerCount = threadCount - 1;
+        }
+        resize(workerCount);
+        count = std::min(count, workerCount + 1);
+    }
+    if (count <= 1) {
+        body(begin, end);
+        return;
+    }
+    DrivingLoop driving;
+
+    std::mutex doneMutex;
+    condition_variable done;
+    int pending = count - 1;
+    exception_ptr failure;
+    int span = end - begin;
+    auto rangeStart = [&](int part) { return begin + static_cast<int>(static_cast<long long>(span) * part / count); };
+    {
+        lock_guard<std::mutex> lock(queueMutex);
+        for (int part = 1; part < count; ++part) {
+            int from = rangeStart(part), to = rangeStart(part + 1);
+            tasks.push_back([&, from, to] {
+                exception_ptr error;
+                try {
+                    body(from, to);
+                } catch (...) {
+                    error = current_exception();
+                }
+                lock_guard<std::mutex> doneLock(doneMutex);
+                if (error && !failure) {
+                    failure = error;
+                }
+                if (--pending == 0) {
+                    done.notify_one();
+                }
+            });
+        }
+    }
+    taskReady.notify_all();
+
+    exception_ptr error;
+    try {
+        body(begin, rangeStart(1));
+    } catch (...) {
+        error = current_exception();
+    }
+    unique_lock<std::mutex> doneLock(doneMutex);
+    done.wait(doneLock, [&] { return pending == 0; });
+    if (error) {
+        rethrow_exception(error);
+    }
+    if (failure) {
+        rethrow_exception(failure);
+    }
+}
+
+/**
+ * Runs body over [begin, end) in chunks claimed one at a time from a shared counter.
+ *
+ * @param begin The first index.
+ * @param end One past the last index.
+ * @param grain The number of indices in a chunk.
+ * @param workPerIndex The average cost of one index, compared against the parallel threshold.
+ * @param body Called as body(chunkBegin, chunkEnd).
+ */
+void ThreadPool::parallelForDynamic(int begin, int end, int grain, long long workPerIndex, const function<void(int, int)>& body) {
+    if (begin >= end) {
+        return;
+    }
+    grain = std::max(grain, 1);
+    int chunks = static_cast<int>((static_cast<long long>(end) - begin + grain - 1) / grain);
+    int participants = std::min(getThreadCount(), chunks);
+    atomic<int> nextChunk(0);
+    // Each participant drains the counter, so a serial fallback runs every chunk in order
+    parallelFor(0, participants, workPerIndex * (end - begin) / participants, [&](int, int) {
+        for (int chunk = nextChunk++; chunk < chunks; chunk = nextChunk++) {
+            int from = begin + chunk * grain;
+            body(from, static_cast<int>(std::min<long long>(end, static_cast<long long>(from) + grain)));
+        }
+    });
+}
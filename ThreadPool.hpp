@@ -0,0 +1,99 @@
+// Nadav034@gmail.com
+
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+/**
+ * Process-wide pool of worker threads shared by the graph operators and
+ * algorithms. Work is handed out as contiguous index ranges, so callers
+ * partition rows (or vertices) and every range is processed exactly once.
+ */
+class ThreadPool {
+public:
+    /**
+     * Returns the pool shared by the whole program. Workers are started lazily,
+     * on the first call that actually runs in parallel.
+     *
+     * @return The shared pool.
+     */
+    static ThreadPool& shared();
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * Sets how many threads, including the caller, take part in a parallel loop.
+     *
+     * @param count The parallelism level; 1 runs everything serially and 0 uses every hardware thread.
+     * @throws std::invalid_argument if count is negative.
+     */
+    void setThreadCount(int count);
+
+    /**
+     * @return The number of threads taking part in a parallel loop.
+     */
+    int getThreadCount() const;
+
+    /**
+     * Sets the least amount of work, in units chosen by the callers (matrix
+     * cells for the graph operators), worth splitting across threads.
+     *
+     * @param work The threshold; smaller loops run on the calling thread.
+     */
+    void setMinParallelWork(long long work);
+
+    /**
+     * @return The least amount of work split across threads.
+     */
+    long long getMinParallelWork() const;
+
+    /**
+     * Runs body over [begin, end), split into contiguous ranges processed
+     * concurrently. The calling thread takes one range itself. Loops that are
+     * too small, or that are started from inside a range of another loop, run
+     * serially. Loops driven from different threads share the workers.
+     * If a range throws, the first exception is rethrown once all ranges finish.
+     *
+     * @param begin The first index.
+     * @param end One past the last index.
+     * @param workPerIndex The cost of one index, compared against the parallel threshold.
+     * @param body Called as body(rangeBegin, rangeEnd).
+     */
+    void parallelFor(int begin, int end, long long workPerIndex, const std::function<void(int, int)>& body);
+
+    /**
+     * Runs body over [begin, end) in chunks of grain indices that the taking
+     * part threads claim one at a time, so threads that finish early keep
+     * taking chunks off the slower ones. Suits loops whose indices differ a
+     * lot in cost. Chunk c always covers [begin + c * grain, begin + (c + 1) * grain).
+     *
+     * @param begin The first index.
+     * @param end One past the last index.
+     * @param grain The number of indices in a chunk.
+     * @param workPerIndex The average cost of one index, compared against the parallel threshold.
+     * @param body Called as body(chunkBegin, chunkEnd).
+     */
+    void parallelForDynamic(int begin, int end, int grain, long long workPerIndex, const std::function<void(int, int)>& body);
+
+private:
+    ThreadPool();
+
+    void resize(int workerCount);
+    void workerLoop();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    mutable std::mutex queueMutex;
+    std::mutex resizeMutex;              // held while the worker set changes
+    std::condition_variable taskReady;
+    bool stopping;
+    int threadCount;
+    long long minParallelWork;
+};